@@ -0,0 +1,88 @@
+/*
+	Copyright (c) 2010, Markus Wagner (bgld)
+	All rights reserved.
+
+	Redistribution and use in source and binary forms, with or without
+	modification, are permitted provided that the following conditions are
+	met:
+	- Redistributions of source code must retain the above copyright
+	  notice, this list of conditions and the following disclaimer.
+	- Redistributions in binary form must reproduce the above copyright
+	  notice, this list of conditions and the following disclaimer in the
+	  documentation and/or other materials provided with the distribution.
+	- Neither the name "fawesome" or "FawesomeEngine" nor the names of its contributors
+	  may be used to endorse or promote products derived from this software
+	  without specific prior written permission.
+
+	THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+	"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+	LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+	PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL MARKUS WAGNER BE
+	LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+	CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+	SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+	INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+	CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+	ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+	THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "allocations.h"
+
+#include <new>
+#include <stdlib.h>
+
+static volatile uint32_t allocations = 0;
+
+uint32_t allocation_count() {
+	return allocations;
+}
+
+void count_allocation() {
+	__sync_fetch_and_add(&allocations, 1);
+}
+
+static void* allocate(size_t size) {
+	count_allocation();
+
+	void* memory = malloc(size > 0 ? size : 1);
+
+	if(memory == NULL)
+		throw std::bad_alloc();
+
+	return memory;
+}
+
+// Dynamic exception specifications are gone in C++17, noexcept means the same there
+
+#if __cplusplus >= 201103L
+#	define ALLOCATION_THROWS noexcept(false)
+#	define ALLOCATION_NOTHROW noexcept
+#else
+#	define ALLOCATION_THROWS throw(std::bad_alloc)
+#	define ALLOCATION_NOTHROW throw()
+#endif
+
+void* operator new(size_t size) ALLOCATION_THROWS {
+	return allocate(size);
+}
+
+void* operator new[](size_t size) ALLOCATION_THROWS {
+	return allocate(size);
+}
+
+void operator delete(void* memory) ALLOCATION_NOTHROW {
+	free(memory);
+}
+
+void operator delete[](void* memory) ALLOCATION_NOTHROW {
+	free(memory);
+}
+
+void operator delete(void* memory, size_t) ALLOCATION_NOTHROW {
+	free(memory);
+}
+
+void operator delete[](void* memory, size_t) ALLOCATION_NOTHROW {
+	free(memory);
+}
@@ -0,0 +1,350 @@
+/*
+	Copyright (c) 2010, Markus Wagner (bgld)
+	All rights reserved.
+
+	Redistribution and use in source and binary forms, with or without
+	modification, are permitted provided that the following conditions are
+	met:
+	- Redistributions of source code must retain the above copyright
+	  notice, this list of conditions and the following disclaimer.
+	- Redistributions in binary form must reproduce the above copyright
+	  notice, this list of conditions and the following disclaimer in the
+	  documentation and/or other materials provided with the distribution.
+	- Neither the name "fawesome" or "FawesomeEngine" nor the names of its contributors
+	  may be used to endorse or promote products derived from this software
+	  without specific prior written permission.
+
+	THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+	"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+	LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+	PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL MARKUS WAGNER BE
+	LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+	CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+	SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+	INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+	CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+	ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+	THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "archive.h"
+
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <algorithm>
+#include <string.h>
+#include <stdio.h>
+#include <SDL/SDL.h>
+#include <SDL/SDL_image.h>
+#include <sys/stat.h>
+
+#ifdef WIN32
+#        include <windows.h>
+#else
+#        include <sys/mman.h>
+#        include <fcntl.h>
+#        include <unistd.h>
+#endif
+
+#include "filenotfoundexception.h"
+
+#define ARCHIVE_ALIGNMENT 16
+
+struct entry_less {
+	inline bool operator()(const asset_entry& lhs, const asset_entry& rhs) const {
+		return lhs.hash < rhs.hash;
+	}
+
+	inline bool operator()(const asset_entry& lhs, uint32_t rhs) const {
+		return lhs.hash < rhs;
+	}
+};
+
+asset_archive::asset_archive(const std::string& file) {
+	m_data = NULL;
+	m_size = 0;
+	m_mtime = 0;
+
+	struct stat info;
+
+	if(stat(file.c_str(), &info) == 0)
+		m_mtime = info.st_mtime;
+
+#ifdef WIN32
+	m_mapping = NULL;
+	m_file = CreateFile(file.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+
+	if(m_file == INVALID_HANDLE_VALUE)
+		throw file_not_found_exception(file);
+
+	m_size = GetFileSize(m_file, NULL);
+	m_mapping = CreateFileMapping(m_file, NULL, PAGE_READONLY, 0, 0, NULL);
+
+	if(m_mapping != NULL)
+		m_data = (const uint8_t*)MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0);
+#else
+	m_file = open(file.c_str(), O_RDONLY);
+
+	if(m_file < 0)
+		throw file_not_found_exception(file);
+
+	if(fstat(m_file, &info) == 0 && info.st_size > 0) {
+		m_size = info.st_size;
+
+		void* mapped = mmap(NULL, m_size, PROT_READ, MAP_SHARED, m_file, 0);
+
+		if(mapped != MAP_FAILED)
+			m_data = (const uint8_t*)mapped;
+	}
+#endif
+
+	if(m_data == NULL) {
+		unmap();
+		throw std::runtime_error("Could not map archive " + file + ".");
+	}
+
+	const header* head = (const header*)m_data;
+
+	if(m_size < sizeof(header) || head->magic != MAGIC || head->version != VERSION || sizeof(header) + (uint64_t)head->count * sizeof(asset_entry) > m_size) {
+		unmap();
+		throw std::runtime_error("Invalid or outdated archive " + file + ".");
+	}
+
+	m_count = head->count;
+	m_entries = (const asset_entry*)(m_data + sizeof(header));
+
+	// Names and blobs are read straight from the mapping later, so a truncated or corrupt file is rejected here once
+
+	for(uint32_t i = 0; i < m_count; i++) {
+		if(!valid(m_entries[i])) {
+			unmap();
+			throw std::runtime_error("Corrupt archive " + file + ".");
+		}
+	}
+}
+
+bool asset_archive::valid(const asset_entry& entry) const {
+	if((uint64_t)entry.name_offset + entry.name_length > m_size || (uint64_t)entry.offset + entry.size > m_size)
+		return false;
+
+	if(entry.type == ENCODED)
+		return true;
+
+	return
+		entry.type == PIXELS &&
+		entry.bpp > 0 && entry.bpp <= 32 && entry.bpp % 8 == 0 &&
+		(uint64_t)entry.width * (entry.bpp / 8) <= entry.pitch &&
+		(uint64_t)entry.pitch * entry.height <= entry.size;
+}
+
+asset_archive::~asset_archive() {
+	unmap();
+}
+
+void asset_archive::unmap() {
+#ifdef WIN32
+	if(m_data != NULL)
+		UnmapViewOfFile(m_data);
+	if(m_mapping != NULL)
+		CloseHandle(m_mapping);
+	if(m_file != INVALID_HANDLE_VALUE)
+		CloseHandle(m_file);
+
+	m_mapping = NULL;
+	m_file = INVALID_HANDLE_VALUE;
+#else
+	if(m_data != NULL)
+		munmap((void*)m_data, m_size);
+	if(m_file >= 0)
+		close(m_file);
+
+	m_file = -1;
+#endif
+
+	m_data = NULL;
+}
+
+const asset_entry* asset_archive::find(const std::string& name) const {
+	uint32_t name_hash = hash(name);
+
+	const asset_entry* end = m_entries + m_count;
+
+	for(
+		const asset_entry* iter = std::lower_bound(m_entries, end, name_hash, entry_less());
+		iter != end && iter->hash == name_hash;
+		iter++
+	) {
+		if(iter->name_length == name.size() && memcmp(m_data + iter->name_offset, name.data(), name.size()) == 0)
+			return iter;
+	}
+
+	return NULL;
+}
+
+const uint8_t* asset_archive::data(const asset_entry* entry) const {
+	return m_data + entry->offset;
+}
+
+uint32_t asset_archive::count() const {
+	return m_count;
+}
+
+time_t asset_archive::modified() const {
+	return m_mtime;
+}
+
+uint32_t asset_archive::hash(const std::string& name) {
+	// FNV-1a
+
+	uint32_t value = 2166136261u;
+
+	for(
+		std::string::const_iterator iter = name.begin();
+		iter != name.end();
+		iter++
+	) {
+		value ^= (uint8_t)*iter;
+		value *= 16777619u;
+	}
+
+	return value;
+}
+
+void asset_archive::build(const std::string& file, const std::vector<std::string>& names, bool decode) {
+	std::vector<asset_entry> entries;
+	std::vector<std::string> blobs;
+	std::string name_blob;
+
+	for(
+		std::vector<std::string>::const_iterator iter = names.begin();
+		iter != names.end();
+		iter++
+	) {
+		asset_entry entry;
+		memset(&entry, 0, sizeof(entry));
+
+		entry.hash = hash(*iter);
+		entry.name_offset = name_blob.size();
+		entry.name_length = iter->size();
+		entry.type = ENCODED;
+
+		name_blob.append(*iter);
+
+		std::string blob;
+		SDL_Surface* image = decode ? IMG_Load(iter->c_str()) : NULL;
+
+		if(image != NULL) {
+			// Convert to 32 bit ARGB, colour keys end up as transparent pixels
+
+			SDL_Surface* target = SDL_CreateRGBSurface(SDL_SWSURFACE, 1, 1, 32, 0x00FF0000, 0x0000FF00, 0x000000FF, 0xFF000000);
+			SDL_Surface* converted = SDL_ConvertSurface(image, target->format, SDL_SWSURFACE);
+
+			SDL_FreeSurface(target);
+			SDL_FreeSurface(image);
+
+			if(converted == NULL)
+				throw std::runtime_error("Could not convert " + *iter + ".");
+
+			entry.type = PIXELS;
+			entry.width = converted->w;
+			entry.height = converted->h;
+			entry.pitch = converted->pitch;
+			entry.bpp = converted->format->BitsPerPixel;
+			entry.rmask = converted->format->Rmask;
+			entry.gmask = converted->format->Gmask;
+			entry.bmask = converted->format->Bmask;
+			entry.amask = converted->format->Amask;
+
+			SDL_LockSurface(converted);
+			blob.assign((const char*)converted->pixels, converted->pitch * converted->h);
+			SDL_UnlockSurface(converted);
+
+			SDL_FreeSurface(converted);
+		} else {
+			std::ifstream stream(iter->c_str(), std::fstream::binary);
+
+			if(stream.fail())
+				throw file_not_found_exception(*iter);
+
+			std::stringstream contents;
+			contents << stream.rdbuf();
+			blob = contents.str();
+		}
+
+		entry.size = blob.size();
+
+		entries.push_back(entry);
+		blobs.push_back(blob);
+	}
+
+	// Lay out index, names and aligned blobs
+
+	uint32_t offset = sizeof(header) + entries.size() * sizeof(asset_entry);
+
+	for(
+		std::vector<asset_entry>::iterator iter = entries.begin();
+		iter != entries.end();
+		iter++
+	) {
+		iter->name_offset += offset;
+	}
+
+	offset += name_blob.size();
+
+	for(size_t i = 0; i < entries.size(); i++) {
+		offset = (offset + ARCHIVE_ALIGNMENT - 1) & ~(ARCHIVE_ALIGNMENT - 1);
+
+		entries[i].offset = offset;
+		offset += entries[i].size;
+	}
+
+	std::vector<asset_entry> index = entries;
+	std::stable_sort(index.begin(), index.end(), entry_less());
+
+	header head;
+	head.magic = MAGIC;
+	head.version = VERSION;
+	head.count = index.size();
+	head.reserved = 0;
+
+	// Written beside the target and renamed over it, so a running game that still has
+	// the old archive mapped keeps reading the old file rather than a truncated one.
+	std::string temp = file + ".tmp";
+	std::ofstream stream(temp.c_str(), std::fstream::binary);
+
+	if(stream.fail())
+		throw std::runtime_error("Permission denied for file " + temp + ".");
+
+	stream.write((const char*)&head, sizeof(head));
+
+	if(!index.empty())
+		stream.write((const char*)&index[0], index.size() * sizeof(asset_entry));
+
+	stream.write(name_blob.data(), name_blob.size());
+
+	for(size_t i = 0; i < entries.size(); i++) {
+		while((uint32_t)stream.tellp() < entries[i].offset)
+			stream.put(0);
+
+		stream.write(blobs[i].data(), blobs[i].size());
+	}
+
+	stream.close();
+
+	if(stream.fail()) {
+		remove(temp.c_str());
+		throw std::runtime_error("Couldn't write file " + temp + ".");
+	}
+
+#ifdef WIN32
+	bool renamed = MoveFileEx(temp.c_str(), file.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+	bool renamed = rename(temp.c_str(), file.c_str()) == 0;
+#endif
+
+	if(!renamed) {
+		remove(temp.c_str());
+		throw std::runtime_error("Couldn't replace file " + file + ".");
+	}
+}
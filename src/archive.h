@@ -0,0 +1,146 @@
+/*
+        Copyright (c) 2010, Markus Wagner (bgld)
+        All rights reserved.
+
+        Redistribution and use in source and binary forms, with or without
+        modification, are permitted provided that the following conditions are
+        met:
+        - Redistributions of source code must retain the above copyright
+          notice, this list of conditions and the following disclaimer.
+        - Redistributions in binary form must reproduce the above copyright
+          notice, this list of conditions and the following disclaimer in the
+          documentation and/or other materials provided with the distribution.
+        - Neither the name "fawesome" or "FawesomeEngine" nor the names of its contributors
+          may be used to endorse or promote products derived from this software
+          without specific prior written permission.
+
+        THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+        "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+        LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+        PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL MARKUS WAGNER BE
+        LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+        CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+        SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+        INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+        CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+        ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+        THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef ARCHIVE_H
+#define ARCHIVE_H
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include <time.h>
+
+
+/**
+ * Index record of an asset archive. The index is sorted by name hash.
+ */
+struct asset_entry {
+    uint32_t hash;
+
+    uint32_t name_offset;
+    uint32_t name_length;
+
+    uint32_t type;
+
+    uint32_t offset;
+    uint32_t size;
+
+    // Only used by pre-decoded pixel entries
+
+    uint32_t width, height, pitch, bpp;
+    uint32_t rmask, gmask, bmask, amask;
+};
+
+/**
+ * Read-only archive of game assets, memory-mapped as a whole.
+ * Layout: header, index of asset_entry records, names, then the data blobs.
+ * Blobs are either the original file contents or raw pixels that can be wrapped into a surface without copying.
+ */
+class asset_archive {
+private:
+    struct header {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t count;
+        uint32_t reserved;
+    };
+
+    const uint8_t* m_data;
+    uint32_t m_size;
+
+    const asset_entry* m_entries;
+    uint32_t m_count;
+
+    time_t m_mtime;
+
+#ifdef WIN32
+    void* m_file;
+    void* m_mapping;
+#else
+    int m_file;
+#endif
+
+    void unmap();
+
+    /**
+     * Whether the entry's name and blob lie within the mapping and its pixel layout fits its blob.
+     */
+    bool valid(const asset_entry& entry) const;
+public:
+    enum {
+        ENCODED = 0,
+        PIXELS  = 1
+    };
+
+    static const uint32_t MAGIC = 0x41574146; // "FAWA"
+    static const uint32_t VERSION = 1;
+
+    /**
+     * Maps an archive into memory.
+     *
+     * @param file
+     * 	The archive file. Throws file_not_found_exception if it doesn't exist,
+     * 	std::runtime_error if it is outdated or any entry points outside of it.
+     */
+    asset_archive(const std::string& file);
+    ~asset_archive();
+
+    /**
+     * Looks up an asset by the name it was packed with, e.g. files/img/grass.png.
+     *
+     * @return
+     * 	The index record or NULL if the archive doesn't contain the asset.
+     */
+    const asset_entry* find(const std::string& name) const;
+
+    const uint8_t* data(const asset_entry* entry) const;
+
+    uint32_t count() const;
+
+    /**
+     * The modification time of the archive file, which stands in for that of every asset inside.
+     */
+    time_t modified() const;
+
+    static uint32_t hash(const std::string& name);
+
+    /**
+     * Writes a new archive.
+     *
+     * @param file
+     * 	The archive file to create. It is written to file + ".tmp" first and renamed into place.
+     * @param names
+     * 	The asset files to pack, stored under the names given.
+     * @param decode
+     * 	Whether images should be stored as decoded 32 bit ARGB pixels instead of their file contents.
+     * 	They are used in place where that is the display format and converted once on load elsewhere.
+     */
+    static void build(const std::string& file, const std::vector<std::string>& names, bool decode);
+};
+
+#endif // ARCHIVE_H
@@ -0,0 +1,200 @@
+/*
+	Copyright (c) 2010, Markus Wagner (bgld)
+	All rights reserved.
+
+	Redistribution and use in source and binary forms, with or without
+	modification, are permitted provided that the following conditions are
+	met:
+	- Redistributions of source code must retain the above copyright
+	  notice, this list of conditions and the following disclaimer.
+	- Redistributions in binary form must reproduce the above copyright
+	  notice, this list of conditions and the following disclaimer in the
+	  documentation and/or other materials provided with the distribution.
+	- Neither the name "fawesome" or "FawesomeEngine" nor the names of its contributors
+	  may be used to endorse or promote products derived from this software
+	  without specific prior written permission.
+
+	THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+	"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+	LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+	PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL MARKUS WAGNER BE
+	LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+	CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+	SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+	INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+	CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+	ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+	THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "atlas.h"
+
+#include <stdexcept>
+
+atlas::atlas(uint16_t size, uint16_t max_image) {
+	m_size = size;
+	m_max_image = max_image;
+}
+
+atlas::~atlas() {
+	for(
+		std::vector<sheet>::iterator iter = sheets.begin();
+		iter != sheets.end();
+		iter++
+	) {
+		SDL_FreeSurface((*iter).surface);
+	}
+}
+
+bool atlas::fits(const SDL_Surface* image) const {
+	return image->w <= m_max_image && image->h <= m_max_image && m_max_image <= m_size;
+}
+
+bool atlas::place(sheet& target, uint16_t w, uint16_t h, SDL_Rect& rect) {
+	uint16_t x = target.cursor_x;
+	uint16_t y = target.cursor_y;
+	uint16_t shelf_height = target.shelf_height;
+
+	// Start a new shelf if the image doesn't fit into the remaining width
+
+	if(x + w > m_size) {
+		x = 0;
+		y += shelf_height;
+		shelf_height = 0;
+	}
+
+	// Leaves the sheet as it was if there is no room, a smaller image may still fit on the current shelf
+
+	if(y + h > m_size)
+		return false;
+
+	rect.x = x;
+	rect.y = y;
+	rect.w = w;
+	rect.h = h;
+
+	target.cursor_x = x + w;
+	target.cursor_y = y;
+	target.shelf_height = h > shelf_height ? h : shelf_height;
+
+	return true;
+}
+
+surface_region atlas::pack(SDL_Surface* image) {
+	surface_region region;
+
+	// Convert first so colour keys become alpha and the sheet is in display format
+
+	SDL_Surface* converted = SDL_DisplayFormatAlpha(image);
+
+	if(converted == NULL)
+		converted = image;
+
+	std::vector<sheet>::iterator target = sheets.begin();
+
+	while(target != sheets.end() && !place(*target, converted->w, converted->h, region.rect))
+		target++;
+
+	if(target == sheets.end()) {
+		sheet new_sheet;
+
+		new_sheet.surface = SDL_CreateRGBSurface(
+			SDL_SWSURFACE | SDL_SRCALPHA,
+			m_size,
+			m_size,
+			32,
+
+			converted->format->Rmask,
+			converted->format->Gmask,
+			converted->format->Bmask,
+			converted->format->Amask ? converted->format->Amask : 0xFF000000
+		);
+
+		if(new_sheet.surface == NULL) {
+			if(converted != image)
+				SDL_FreeSurface(converted);
+
+			throw std::runtime_error("Couldn't create atlas sheet");
+		}
+
+		SDL_FillRect(new_sheet.surface, NULL, 0);
+
+		new_sheet.cursor_x = 0;
+		new_sheet.cursor_y = 0;
+		new_sheet.shelf_height = 0;
+		new_sheet.regions = 0;
+
+		sheets.push_back(new_sheet);
+
+		target = sheets.end() - 1;
+
+		place(*target, converted->w, converted->h, region.rect);
+	}
+
+	// Copy the pixels including their alpha channel instead of blending them onto the empty sheet
+
+	SDL_Rect dest = region.rect;
+
+	SDL_SetAlpha(converted, 0, SDL_ALPHA_OPAQUE);
+	SDL_BlitSurface(converted, NULL, (*target).surface, &dest);
+
+	if(converted != image)
+		SDL_FreeSurface(converted);
+
+	(*target).regions++;
+	region.surface = (*target).surface;
+
+	return region;
+}
+
+void atlas::release(const surface_region& region) {
+	for(
+		std::vector<sheet>::iterator iter = sheets.begin();
+		iter != sheets.end();
+		iter++
+	) {
+		if((*iter).surface != region.surface)
+			continue;
+
+		(*iter).regions--;
+
+		if((*iter).regions > 0)
+			break;
+
+		// Nothing left on it, so all of it can be handed out again, but one empty sheet is enough
+
+		bool spare = false;
+
+		for(uint32_t i = 0; i < sheets.size(); i++)
+			spare |= &sheets[i] != &(*iter) && sheets[i].regions == 0;
+
+		if(spare) {
+			SDL_FreeSurface((*iter).surface);
+			sheets.erase(iter);
+		} else {
+			(*iter).cursor_x = 0;
+			(*iter).cursor_y = 0;
+			(*iter).shelf_height = 0;
+		}
+
+		break;
+	}
+}
+
+uint32_t atlas::count() const {
+	return sheets.size();
+}
+
+uint32_t atlas::bytes() const {
+	uint32_t total = 0;
+
+	for(
+		std::vector<sheet>::const_iterator iter = sheets.begin();
+		iter != sheets.end();
+		iter++
+	) {
+		total += (*iter).surface->pitch * (*iter).surface->h;
+	}
+
+	return total;
+}
@@ -0,0 +1,95 @@
+/*
+        Copyright (c) 2010, Markus Wagner (bgld)
+        All rights reserved.
+
+        Redistribution and use in source and binary forms, with or without
+        modification, are permitted provided that the following conditions are
+        met:
+        - Redistributions of source code must retain the above copyright
+          notice, this list of conditions and the following disclaimer.
+        - Redistributions in binary form must reproduce the above copyright
+          notice, this list of conditions and the following disclaimer in the
+          documentation and/or other materials provided with the distribution.
+        - Neither the name "fawesome" or "FawesomeEngine" nor the names of its contributors
+          may be used to endorse or promote products derived from this software
+          without specific prior written permission.
+
+        THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+        "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+        LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+        PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL MARKUS WAGNER BE
+        LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+        CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+        SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+        INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+        CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+        ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+        THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef ATLAS_H
+#define ATLAS_H
+
+#include <vector>
+#include <stdint.h>
+#include <SDL/SDL.h>
+
+
+/**
+ * A rectangle on a surface. Images packed into an atlas share their surface with others,
+ * so anything drawing them has to blit the rect, not the whole surface.
+ */
+struct surface_region {
+    SDL_Surface* surface;
+    SDL_Rect rect;
+};
+
+/**
+ * Packs small images into shared sheets at load time using a simple shelf allocator.
+ * Images go into the first sheet with room. A sheet whose regions have all been released starts over empty,
+ * one such sheet is kept for reuse and any further ones are freed.
+ */
+class atlas {
+private:
+    struct sheet {
+        SDL_Surface* surface;
+
+        uint16_t cursor_x, cursor_y, shelf_height;
+        uint32_t regions;
+    };
+
+    std::vector<sheet> sheets;
+
+    uint16_t m_size;
+    uint16_t m_max_image;
+
+    bool place(sheet& target, uint16_t w, uint16_t h, SDL_Rect& rect);
+public:
+    /**
+     * @param size
+     * 	The width and height of a sheet in pixels.
+     * @param max_image
+     * 	Images wider or higher than this are not packed.
+     */
+    atlas(uint16_t size, uint16_t max_image);
+    ~atlas();
+
+    bool fits(const SDL_Surface* image) const;
+
+    /**
+     * Copies an image into a sheet. The caller keeps ownership of the image.
+     * Throws std::runtime_error if a new sheet is needed and can't be created.
+     */
+    surface_region pack(SDL_Surface* image);
+
+    void release(const surface_region& region);
+
+    uint32_t count() const;
+
+    /**
+     * Memory held by all sheets, used or not.
+     */
+    uint32_t bytes() const;
+};
+
+#endif // ATLAS_H
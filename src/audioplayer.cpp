@@ -29,40 +29,295 @@
 
 #include "audioplayer.h"
 
-#include <iostream>
+#include <string.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <stdexcept>
 
-#include <SDL/SDL_thread.h>
+#include <SDL/SDL.h>
 
 #include "globals.h"
 #include "file.h"
 
-int thread_callback(void* data) {
-	//fawesound_playdata play_data;
 
-	//play_data.loops = 1;
-	//play_data.volume = 100;
+audio_player::audio_player() {
+	m_open = false;
+	next_handle = 1;
+
+	m_samples = NULL;
+	m_music = NULL;
+	music_volume = 256;
+
+	if(!config->bool_value("sound"))
+		return;
+
+	if(SDL_InitSubSystem(SDL_INIT_AUDIO) < 0) {
+		message(std::string("Could not initialize audio, sound is off: ") + SDL_GetError(), false);
+		return;
+	}
+
+	m_spec.freq = atoi(config->value("audio_rate").c_str());
+	m_spec.format = AUDIO_S16SYS;
+	m_spec.channels = 2;
+	m_spec.samples = config->int_value("audio_buffer");
+	m_spec.callback = callback;
+	m_spec.userdata = this;
+
+	// Everything the callback needs is allocated up front
+
+	uint16_t voice_count = config->int_value("audio_voices");
+
+	if(voice_count < 1)
+		voice_count = 1;
+	if(voice_count > RETURNS - COMMANDS)
+		voice_count = RETURNS - COMMANDS;
+
+	voice idle = { 0, NULL, 0, 0, false };
+	voices.resize(voice_count, idle);
+	mix_buffer.resize(m_spec.samples * m_spec.channels);
 
-	//fawesound_play((char*)data, &play_data);
+	// Without an obtained spec SDL converts to exactly this format for us
 
-	return 0;
+	if(SDL_OpenAudio(&m_spec, NULL) < 0) {
+		message(std::string("Could not open audio device, sound is off: ") + SDL_GetError(), false);
+		return;
+	}
+
+	m_open = true;
+
+	m_samples = new sample_cache(config->int_value("sample_budget") * 1024 * 1024, m_spec);
+	m_music = new music_stream(m_spec.freq);
+
+	SDL_PauseAudio(0);
 }
 
-audio_player::audio_player() {
-	//fawesound_init();
+audio_player::~audio_player() {
+	if(!m_open)
+		return;
+
+	SDL_CloseAudio();
+
+	delete m_music;
+
+	// The audio thread is gone, so everything it held can be freed from here
+
+	command order;
+
+	while(commands.pop(order)) {
+		if(order.type == command::PLAY)
+			m_samples->release(order.pcm);
+	}
+
+	for(
+		std::vector<voice>::iterator iter = voices.begin();
+		iter != voices.end();
+		iter++
+	) {
+		if((*iter).handle != 0)
+			m_samples->release((*iter).pcm);
+	}
+
+	update();
+
+	delete m_samples;
+
+	SDL_QuitSubSystem(SDL_INIT_AUDIO);
 }
 
-void audio_player::play_audio(const std::string& name) {
-	if(!config->bool_value("sound"))
+void audio_player::callback(void* data, uint8_t* stream, int length) {
+	audio_player* player = (audio_player*)data;
+
+	command order;
+
+	while(player->commands.pop(order))
+		player->execute(order);
+
+	player->mix((int16_t*)stream, length / sizeof(int16_t));
+}
+
+void audio_player::execute(const command& order) {
+	if(order.type == command::MUSIC_VOLUME) {
+		music_volume = order.volume;
+		return;
+	}
+
+	if(order.type == command::PLAY) {
+		// Take a free voice, or the one that has been playing the longest
+
+		voice* target = &voices[0];
+
+		for(
+			std::vector<voice>::iterator iter = voices.begin();
+			iter != voices.end();
+			iter++
+		) {
+			if((*iter).handle == 0) {
+				target = &*iter;
+				break;
+			}
+
+			if((*iter).handle < target->handle)
+				target = &*iter;
+		}
+
+		if(target->handle != 0)
+			finish(*target);
+
+		target->handle = order.handle;
+		target->pcm = order.pcm;
+		target->position = 0;
+		target->volume = order.volume;
+		target->loop = order.loop;
+
 		return;
+	}
+
+	for(
+		std::vector<voice>::iterator iter = voices.begin();
+		iter != voices.end();
+		iter++
+	) {
+		if((*iter).handle != order.handle)
+			continue;
 
-	std::string file_name = file(name);
-	const char* const_data = file_name.c_str();
-	char* data = new char[strlen(const_data) + 1];
-	strcpy(data, const_data);
+		if(order.type == command::STOP)
+			finish(*iter);
+		else
+			(*iter).volume = order.volume;
 
-	SDL_CreateThread(thread_callback, data);
+		return;
+	}
 }
 
-void audio_player::play_audio_loop(const std::string& name) {
-	play_audio(name);
+void audio_player::mix(int16_t* stream, uint32_t length) {
+	int32_t* mixed = &mix_buffer[0];
+
+	if(length > mix_buffer.size())
+		length = mix_buffer.size();
+
+	memset(mixed, 0, length * sizeof(int32_t));
+
+	for(
+		std::vector<voice>::iterator iter = voices.begin();
+		iter != voices.end();
+		iter++
+	) {
+		voice& playing = *iter;
+
+		if(playing.handle == 0)
+			continue;
+
+		const int16_t* data = playing.pcm->data;
+		int32_t volume = playing.volume;
+
+		uint32_t done = 0;
+
+		while(done < length) {
+			uint32_t run = std::min(length - done, playing.pcm->length - playing.position);
+
+			for(uint32_t i = 0; i < run; i++)
+				mixed[done + i] += (data[playing.position + i] * volume) >> 8;
+
+			done += run;
+			playing.position += run;
+
+			if(playing.position == playing.pcm->length) {
+				if(!playing.loop) {
+					finish(playing);
+					break;
+				}
+
+				playing.position = 0;
+			}
+		}
+	}
+
+	m_music->mix(mixed, length / m_spec.channels, music_volume);
+
+	for(uint32_t i = 0; i < length; i++)
+		stream[i] = std::max(-32768, std::min(32767, mixed[i]));
+}
+
+void audio_player::finish(voice& playing) {
+	returns.push(playing.pcm);
+
+	playing.handle = 0;
+	playing.pcm = NULL;
+}
+
+uint32_t audio_player::play(const std::string& file, uint8_t volume, bool loop) {
+	if(!m_open)
+		return 0;
+
+	update();
+
+	command order;
+	order.type = command::PLAY;
+	order.handle = next_handle;
+	order.pcm = m_samples->fetch(file);
+	order.volume = volume + (volume >> 7); // 255 becomes 256, as recorded
+	order.loop = loop;
+
+	if(!commands.push(order)) {
+		m_samples->release(order.pcm);
+		return 0;
+	}
+
+	return next_handle++;
+}
+
+void audio_player::stop(uint32_t handle) {
+	if(!m_open)
+		return;
+
+	command order;
+	order.type = command::STOP;
+	order.handle = handle;
+	order.pcm = NULL;
+
+	commands.push(order);
+}
+
+void audio_player::volume(uint32_t handle, uint8_t volume) {
+	if(!m_open)
+		return;
+
+	command order;
+	order.type = command::VOLUME;
+	order.handle = handle;
+	order.pcm = NULL;
+	order.volume = volume + (volume >> 7);
+
+	commands.push(order);
+}
+
+void audio_player::update() {
+	const sample* pcm;
+
+	while(returns.pop(pcm))
+		m_samples->release(pcm);
+}
+
+sample_cache* audio_player::samples() const {
+	return m_samples;
+}
+
+void audio_player::music(const std::string& name, uint32_t fade, bool loop) {
+	if(!m_open)
+		return;
+
+	m_music->play(name.empty() ? name : std::string(file(name)), fade, loop);
+}
+
+void audio_player::music_level(uint8_t volume) {
+	if(!m_open)
+		return;
+
+	command order;
+	order.type = command::MUSIC_VOLUME;
+	order.handle = 0;
+	order.pcm = NULL;
+	order.volume = volume + (volume >> 7);
+
+	commands.push(order);
 }
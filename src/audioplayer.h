@@ -31,16 +31,112 @@
 #define AUDIOPLAYER_H
 
 #include <string>
-#include <map>
+#include <vector>
+#include <stdint.h>
+#include <SDL/SDL_audio.h>
 
-//#include <fawesound.h>
+#include "spscqueue.h"
+#include "musicstream.h"
+#include "samplecache.h"
 
+
+/**
+ * Software mixer playing any number of sounds at once from the SDL audio callback.
+ * The game thread fetches sounds from the sample cache and sends commands through a lock-free queue, the audio thread
+ * picks them up at the start of every buffer and hands finished sounds back through another one to be released.
+ * Voices read straight from the cached buffers, however many play the same sound.
+ * Nothing is allocated, locked or freed on the audio thread.
+ */
 class audio_player {
+private:
+    struct command {
+        enum {
+            PLAY,
+            STOP,
+            VOLUME,
+            MUSIC_VOLUME
+        } type;
+
+        uint32_t handle;
+        const sample* pcm;
+        uint16_t volume;
+        bool loop;
+    };
+
+    // Only touched by the audio thread once the device is open
+    struct voice {
+        uint32_t handle; // 0 if free
+        const sample* pcm;
+        uint32_t position;
+        uint16_t volume; // 0 to 256
+        bool loop;
+    };
+
+    static const uint32_t COMMANDS = 256;
+    static const uint32_t RETURNS = 512; // Holds everything that can be in flight, so the audio thread never has to wait
+
+    spsc_queue<command, COMMANDS> commands;
+    spsc_queue<const sample*, RETURNS> returns;
+
+    std::vector<voice> voices;
+    std::vector<int32_t> mix_buffer;
+
+    sample_cache* m_samples;
+    music_stream* m_music;
+    uint16_t music_volume; // Audio thread's copy, 0 to 256
+
+    SDL_AudioSpec m_spec;
+    bool m_open;
+
+    uint32_t next_handle;
+
+    static void callback(void* data, uint8_t* stream, int length);
+
+    void execute(const command& order);
+    void mix(int16_t* stream, uint32_t length);
+    void finish(voice& playing);
 public:
     audio_player();
+    ~audio_player();
+
+    /**
+     * Starts playing a WAV file, throws file_not_found_exception.
+     *
+     * @param volume
+     * 	From 0 (silent) to 255 (as recorded).
+     * @param loop
+     * 	Whether to start over at the end until stopped.
+     * @return
+     * 	The handle to stop it or change its volume with, 0 if sound is off or too much is queued.
+     */
+    uint32_t play(const std::string& file, uint8_t volume = 255, bool loop = false);
+
+    /**
+     * Stops a sound started by play, handles that already ended are ignored.
+     */
+    void stop(uint32_t handle);
+    void volume(uint32_t handle, uint8_t volume);
+
+    /**
+     * Releases the sounds that finished playing, call once per frame.
+     */
+    void update();
+
+    /**
+     * Streams a WAV file as background music, crossfading from the current one.
+     *
+     * @param file
+     * 	Empty to fade out to silence.
+     * @param fade
+     * 	The crossfade in milliseconds.
+     */
+    void music(const std::string& file, uint32_t fade = 0, bool loop = true);
+    void music_level(uint8_t volume);
 
-    void play_audio(const std::string& file);
-    void play_audio_loop(const std::string& file);
+    /**
+     * The sample cache, NULL if sound is off.
+     */
+    sample_cache* samples() const;
 };
 
 #endif // AUDIOPLAYER_H
@@ -0,0 +1,466 @@
+/*
+	Copyright (c) 2010, Markus Wagner (bgld)
+	All rights reserved.
+
+	Redistribution and use in source and binary forms, with or without
+	modification, are permitted provided that the following conditions are
+	met:
+	- Redistributions of source code must retain the above copyright
+	  notice, this list of conditions and the following disclaimer.
+	- Redistributions in binary form must reproduce the above copyright
+	  notice, this list of conditions and the following disclaimer in the
+	  documentation and/or other materials provided with the distribution.
+	- Neither the name "fawesome" or "FawesomeEngine" nor the names of its contributors
+	  may be used to endorse or promote products derived from this software
+	  without specific prior written permission.
+
+	THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+	"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+	LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+	PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL MARKUS WAGNER BE
+	LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+	CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+	SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+	INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+	CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+	ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+	THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "blitter.h"
+
+#include <string.h>
+#include <algorithm>
+#include <stdexcept>
+
+#include <SDL/SDL_rotozoom.h>
+
+#include "allocations.h"
+
+class copy_band : public band_job {
+public:
+	uint8_t* src;
+	uint8_t* dst;
+	uint16_t src_pitch;
+	uint16_t dst_pitch;
+	uint32_t length;
+
+	void process(uint16_t first, uint16_t end) {
+		for(uint16_t y = first; y < end; y++)
+			memcpy(dst + y * dst_pitch, src + y * src_pitch, length);
+	}
+};
+
+static int32_t wrap(int32_t value, int32_t size) {
+	value %= size;
+
+	return value < 0 ? value + size : value;
+}
+
+class zoom_band : public band_job {
+public:
+	SDL_Surface* src;
+	SDL_Surface* dst;
+	int32_t x;
+	int32_t y;
+	int32_t first_x;
+	int32_t end_x;
+	int32_t first_y;
+	uint16_t factor;
+
+	const color_table* table;
+	uint32_t mask[3];
+	uint8_t shift[3];
+
+	const overlay_layer* overlay;
+	uint32_t alpha_mask;
+	uint8_t alpha_shift;
+
+	uint32_t lookup(uint32_t pixel) const {
+		uint32_t result = pixel & ~(mask[0] | mask[1] | mask[2]);
+
+		for(uint8_t i = 0; i < 3; i++)
+			result |= (uint32_t)table->channel[i][(pixel & mask[i]) >> shift[i]] << shift[i];
+
+		return result;
+	}
+
+	uint32_t fetch(uint32_t pixel, const uint32_t* over, int32_t over_x) const {
+		if(over != NULL)
+			pixel = blitter::blend(pixel, over[over_x], alpha_mask, alpha_shift, overlay->opacity);
+
+		return table != NULL ? lookup(pixel) : pixel;
+	}
+
+	void process(uint16_t first, uint16_t end) {
+		uint32_t* previous = NULL;
+
+		for(uint16_t row = first; row < end; row++) {
+			int32_t dst_y = first_y + row;
+			uint32_t* out = (uint32_t*)((uint8_t*)dst->pixels + dst_y * dst->pitch) + first_x;
+
+			// Rows scaled from the same source row are identical
+
+			if(previous != NULL && (dst_y - y) % factor != 0) {
+				memcpy(out, previous, (end_x - first_x) * 4);
+			} else {
+				int32_t sy = (dst_y - y) / factor;
+				uint32_t* in = (uint32_t*)((uint8_t*)src->pixels + sy * src->pitch);
+
+				int32_t sx = (first_x - x) / factor;
+				uint16_t repeat = (first_x - x) % factor;
+
+				// The overlay repeats, so walk its row with a wrapping column
+
+				const uint32_t* over = NULL;
+				int32_t over_x = 0;
+
+				if(overlay != NULL) {
+					SDL_Surface* texture = overlay->surface;
+
+					over = (const uint32_t*)((uint8_t*)texture->pixels + wrap(sy + overlay->y, texture->h) * texture->pitch);
+					over_x = wrap(sx + overlay->x, texture->w);
+				}
+
+				uint32_t pixel = fetch(in[sx], over, over_x);
+
+				for(int32_t dst_x = first_x; dst_x < end_x; dst_x++) {
+					out[dst_x - first_x] = pixel;
+
+					if(++repeat == factor) {
+						repeat = 0;
+						sx++;
+
+						if(over != NULL && ++over_x == overlay->surface->w)
+							over_x = 0;
+
+						if(dst_x + 1 < end_x)
+							pixel = fetch(in[sx], over, over_x);
+					}
+				}
+			}
+
+			previous = out;
+		}
+	}
+};
+
+static bool clip(SDL_Surface* src, SDL_Rect* src_rect, SDL_Surface* dst, SDL_Rect* dst_rect, SDL_Rect& from, SDL_Rect& to) {
+	// Same clipping rules as SDL_BlitSurface, dst_rect receives the final rectangle
+
+	int32_t sx = 0;
+	int32_t sy = 0;
+	int32_t w = src->w;
+	int32_t h = src->h;
+
+	if(src_rect != NULL) {
+		sx = src_rect->x;
+		sy = src_rect->y;
+		w = src_rect->w;
+		h = src_rect->h;
+	}
+
+	int32_t dx = dst_rect != NULL ? dst_rect->x : 0;
+	int32_t dy = dst_rect != NULL ? dst_rect->y : 0;
+
+	if(sx < 0) {
+		w += sx;
+		dx -= sx;
+		sx = 0;
+	}
+	if(sy < 0) {
+		h += sy;
+		dy -= sy;
+		sy = 0;
+	}
+
+	w = std::min(w, src->w - sx);
+	h = std::min(h, src->h - sy);
+
+	const SDL_Rect& bounds = dst->clip_rect;
+
+	if(dx < bounds.x) {
+		w -= bounds.x - dx;
+		sx += bounds.x - dx;
+		dx = bounds.x;
+	}
+	if(dy < bounds.y) {
+		h -= bounds.y - dy;
+		sy += bounds.y - dy;
+		dy = bounds.y;
+	}
+
+	w = std::min(w, bounds.x + bounds.w - dx);
+	h = std::min(h, bounds.y + bounds.h - dy);
+
+	if(w < 0)
+		w = 0;
+	if(h < 0)
+		h = 0;
+
+	from.x = sx;
+	from.y = sy;
+	from.w = w;
+	from.h = h;
+
+	to.x = dx;
+	to.y = dy;
+	to.w = w;
+	to.h = h;
+
+	if(dst_rect != NULL)
+		*dst_rect = to;
+
+	return w > 0 && h > 0;
+}
+
+job_pool* blitter::pool = NULL;
+std::vector<SDL_Surface*> blitter::scratch_surfaces;
+
+void blitter::init(uint16_t threads) {
+	if(pool == NULL)
+		pool = new job_pool(threads);
+}
+
+void blitter::quit() {
+	delete pool;
+	pool = NULL;
+
+	for(
+		std::vector<SDL_Surface*>::iterator iter = scratch_surfaces.begin();
+		iter != scratch_surfaces.end();
+		iter++
+	) {
+		SDL_FreeSurface(*iter);
+	}
+
+	scratch_surfaces.clear();
+}
+
+uint8_t blitter::spare_shift(const SDL_PixelFormat* format) {
+	// The four byte shifts add up to 48
+	return 48 - format->Rshift - format->Gshift - format->Bshift;
+}
+
+uint16_t blitter::threads() {
+	return pool != NULL ? pool->threads() + 1 : 1;
+}
+
+bool blitter::same_format(SDL_Surface* src, SDL_Surface* dst) {
+	return
+		src->format->BytesPerPixel == 4 &&
+		dst->format->BytesPerPixel == 4 &&
+		src->format->Rmask == dst->format->Rmask &&
+		src->format->Gmask == dst->format->Gmask &&
+		src->format->Bmask == dst->format->Bmask;
+}
+
+void blitter::copy(SDL_Surface* src, SDL_Rect* src_rect, SDL_Surface* dst, SDL_Rect* dst_rect) {
+	// Anything that would actually blend or key pixels is left to SDL
+
+	bool blends = (src->flags & SDL_SRCCOLORKEY) || ((src->flags & SDL_SRCALPHA) && (src->format->Amask != 0 || src->format->alpha != SDL_ALPHA_OPAQUE));
+
+	if(pool == NULL || src == dst || blends || !same_format(src, dst)) {
+		SDL_BlitSurface(src, src_rect, dst, dst_rect);
+		return;
+	}
+
+	SDL_Rect from;
+	SDL_Rect to;
+
+	if(!clip(src, src_rect, dst, dst_rect, from, to))
+		return;
+
+	SDL_LockSurface(src);
+	SDL_LockSurface(dst);
+
+	copy_band job;
+	job.src = (uint8_t*)src->pixels + from.y * src->pitch + from.x * 4;
+	job.dst = (uint8_t*)dst->pixels + to.y * dst->pitch + to.x * 4;
+	job.src_pitch = src->pitch;
+	job.dst_pitch = dst->pitch;
+	job.length = from.w * 4;
+
+	pool->run(&job, from.h);
+
+	SDL_UnlockSurface(dst);
+	SDL_UnlockSurface(src);
+}
+
+void blitter::apply(SDL_Surface* surface, const color_table* table) {
+	SDL_PixelFormat* format = surface->format;
+
+	SDL_LockSurface(surface);
+
+	for(uint16_t y = 0; y < surface->h; y++) {
+		uint32_t* pixel = (uint32_t*)((uint8_t*)surface->pixels + y * surface->pitch);
+		uint32_t* last = pixel + surface->w;
+
+		for(; pixel != last; pixel++) {
+			SDL_Color color;
+			SDL_GetRGB(*pixel, format, &color.r, &color.g, &color.b);
+
+			*pixel = (*pixel & format->Amask) | SDL_MapRGB(format, table->channel[0][color.r], table->channel[1][color.g], table->channel[2][color.b]);
+		}
+	}
+
+	SDL_UnlockSurface(surface);
+}
+
+void blitter::composite(SDL_Surface* surface, const overlay_layer* overlay) {
+	SDL_PixelFormat* format = surface->format;
+	SDL_Surface* texture = overlay->surface;
+
+	uint8_t alpha_shift = spare_shift(format);
+	uint32_t alpha_mask = 0xffu << alpha_shift;
+
+	SDL_LockSurface(surface);
+	SDL_LockSurface(texture);
+
+	for(uint16_t y = 0; y < surface->h; y++) {
+		uint32_t* pixel = (uint32_t*)((uint8_t*)surface->pixels + y * surface->pitch);
+		const uint32_t* over = (const uint32_t*)((uint8_t*)texture->pixels + wrap(y + overlay->y, texture->h) * texture->pitch);
+		int32_t over_x = wrap(overlay->x, texture->w);
+
+		for(uint16_t x = 0; x < surface->w; x++) {
+			pixel[x] = blend(pixel[x], over[over_x], alpha_mask, alpha_shift, overlay->opacity);
+
+			if(++over_x == texture->w)
+				over_x = 0;
+		}
+	}
+
+	SDL_UnlockSurface(texture);
+	SDL_UnlockSurface(surface);
+}
+
+void blitter::zoom(SDL_Surface* src, SDL_Surface* dst, SDL_Rect* dst_rect, uint16_t factor, const color_table* table, const overlay_layer* overlay) {
+	if(factor < 1)
+		factor = 1;
+
+	SDL_PixelFormat* format = src->format;
+
+	// The lookup and blending in the fast path assume 8 bits per channel
+
+	if(pool == NULL || !same_format(src, dst) || format->Rloss != 0 || format->Gloss != 0 || format->Bloss != 0) {
+		// src is drawn anew every frame, so the overlay may as well go straight onto it
+
+		if(overlay != NULL && format->BytesPerPixel == 4)
+			composite(src, overlay);
+
+		SDL_Surface* zoomed = zoomSurface(src, factor, factor, 0);
+
+		if(table != NULL && zoomed->format->BytesPerPixel == 4)
+			apply(zoomed, table);
+
+		SDL_BlitSurface(zoomed, NULL, dst, dst_rect);
+		SDL_FreeSurface(zoomed);
+		return;
+	}
+
+	zoom_band job;
+	job.src = src;
+	job.dst = dst;
+	job.x = dst_rect != NULL ? dst_rect->x : 0;
+	job.y = dst_rect != NULL ? dst_rect->y : 0;
+	job.factor = factor;
+
+	job.table = table;
+	job.mask[0] = format->Rmask;
+	job.mask[1] = format->Gmask;
+	job.mask[2] = format->Bmask;
+	job.shift[0] = format->Rshift;
+	job.shift[1] = format->Gshift;
+	job.shift[2] = format->Bshift;
+
+	job.overlay = overlay;
+	job.alpha_shift = spare_shift(format);
+	job.alpha_mask = 0xffu << job.alpha_shift;
+
+	const SDL_Rect& bounds = dst->clip_rect;
+
+	job.first_x = std::max<int32_t>(job.x, bounds.x);
+	job.end_x = std::min<int32_t>(job.x + src->w * factor, bounds.x + bounds.w);
+	job.first_y = std::max<int32_t>(job.y, bounds.y);
+
+	int32_t end_y = std::min<int32_t>(job.y + src->h * factor, bounds.y + bounds.h);
+
+	if(job.end_x <= job.first_x || end_y <= job.first_y)
+		return;
+
+	SDL_LockSurface(src);
+	SDL_LockSurface(dst);
+
+	if(overlay != NULL)
+		SDL_LockSurface(overlay->surface);
+
+	pool->run(&job, end_y - job.first_y);
+
+	if(overlay != NULL)
+		SDL_UnlockSurface(overlay->surface);
+
+	SDL_UnlockSurface(dst);
+	SDL_UnlockSurface(src);
+}
+
+SDL_Surface* blitter::scratch(uint16_t w, uint16_t h, SDL_PixelFormat* format) {
+	// Smallest free one that fits
+
+	std::vector<SDL_Surface*>::iterator best = scratch_surfaces.end();
+
+	for(
+		std::vector<SDL_Surface*>::iterator iter = scratch_surfaces.begin();
+		iter != scratch_surfaces.end();
+		iter++
+	) {
+		SDL_PixelFormat* candidate = (*iter)->format;
+
+		if(
+			(*iter)->w >= w && (*iter)->h >= h &&
+			candidate->BitsPerPixel == format->BitsPerPixel &&
+			candidate->Rmask == format->Rmask &&
+			candidate->Gmask == format->Gmask &&
+			candidate->Bmask == format->Bmask &&
+			candidate->Amask == format->Amask &&
+			(best == scratch_surfaces.end() || (*iter)->w * (*iter)->h < (*best)->w * (*best)->h)
+		) {
+			best = iter;
+		}
+	}
+
+	if(best != scratch_surfaces.end()) {
+		SDL_Surface* surface = *best;
+		scratch_surfaces.erase(best);
+
+		return surface;
+	}
+
+	count_allocation();
+
+	uint16_t pool_w = (w + SCRATCH_GRANULARITY - 1) / SCRATCH_GRANULARITY * SCRATCH_GRANULARITY;
+	uint16_t pool_h = (h + SCRATCH_GRANULARITY - 1) / SCRATCH_GRANULARITY * SCRATCH_GRANULARITY;
+
+	SDL_Surface* surface = SDL_CreateRGBSurface(
+		SDL_SWSURFACE,
+		pool_w,
+		pool_h,
+		format->BitsPerPixel,
+
+		format->Rmask,
+		format->Gmask,
+		format->Bmask,
+		format->Amask
+	);
+
+	if(surface == NULL)
+		throw std::runtime_error("Couldn't create scratch surface");
+
+	return surface;
+}
+
+void blitter::release(SDL_Surface* surface) {
+	// The next user sets its own alpha
+	SDL_SetAlpha(surface, 0, SDL_ALPHA_OPAQUE);
+
+	scratch_surfaces.push_back(surface);
+}
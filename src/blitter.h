@@ -0,0 +1,119 @@
+/*
+        Copyright (c) 2010, Markus Wagner (bgld)
+        All rights reserved.
+
+        Redistribution and use in source and binary forms, with or without
+        modification, are permitted provided that the following conditions are
+        met:
+        - Redistributions of source code must retain the above copyright
+          notice, this list of conditions and the following disclaimer.
+        - Redistributions in binary form must reproduce the above copyright
+          notice, this list of conditions and the following disclaimer in the
+          documentation and/or other materials provided with the distribution.
+        - Neither the name "fawesome" or "FawesomeEngine" nor the names of its contributors
+          may be used to endorse or promote products derived from this software
+          without specific prior written permission.
+
+        THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+        "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+        LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+        PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL MARKUS WAGNER BE
+        LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+        CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+        SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+        INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+        CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+        ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+        THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef BLITTER_H
+#define BLITTER_H
+
+#include <vector>
+#include <stdint.h>
+#include <SDL/SDL.h>
+
+#include "jobpool.h"
+
+
+/**
+ * Per channel lookup tables for red, green and blue, applied on the way through a blit.
+ */
+struct color_table {
+    uint8_t channel[3][256];
+};
+
+/**
+ * A texture composited over the source during zoom(), repeating if it's smaller than the source.
+ * Pixels are in the source's format, with alpha in the byte the color doesn't use, and pre-multiplied by it.
+ */
+struct overlay_layer {
+    SDL_Surface* surface;
+    int32_t x, y; // Texture position at the source's top left corner
+    uint16_t opacity; // 0 to 256
+};
+
+/**
+ * Software blits for the full-screen composition steps, split into bands of rows across the job pool.
+ * The fast paths need 4 byte pixels in matching formats and fall back to SDL otherwise.
+ */
+class blitter {
+private:
+    static job_pool* pool;
+
+    static std::vector<SDL_Surface*> scratch_surfaces; // Free ones only
+
+    static bool same_format(SDL_Surface* src, SDL_Surface* dst);
+
+    static void apply(SDL_Surface* surface, const color_table* table);
+    static void composite(SDL_Surface* surface, const overlay_layer* overlay);
+public:
+    static void init(uint16_t threads);
+    static void quit();
+
+    static uint16_t threads();
+
+    /**
+     * Shift of the byte the color channels leave over in a 4 byte format, where overlays keep their alpha.
+     */
+    static uint8_t spare_shift(const SDL_PixelFormat* format);
+
+    /**
+     * Opaque copy with the same arguments and clipping as SDL_BlitSurface.
+     */
+    static void copy(SDL_Surface* src, SDL_Rect* src_rect, SDL_Surface* dst, SDL_Rect* dst_rect);
+
+    /**
+     * Nearest neighbour upscale of src by an integral factor, placed at the position of dst_rect.
+     * Each source pixel gets overlay blended on top and is run through table on the way, if given.
+     * Both happen once per source pixel, before scaling.
+     */
+    static void zoom(SDL_Surface* src, SDL_Surface* dst, SDL_Rect* dst_rect, uint16_t factor, const color_table* table = NULL, const overlay_layer* overlay = NULL);
+
+    /**
+     * Blends a pre-multiplied pixel over another, both with 8 bits in each of their 4 bytes.
+     * Two channels are done per multiplication, alpha is taken from the byte selected by alpha_mask.
+     */
+    static inline uint32_t blend(uint32_t pixel, uint32_t over, uint32_t alpha_mask, uint8_t alpha_shift, uint16_t opacity) {
+        uint32_t coverage = (((over & alpha_mask) >> alpha_shift) * opacity + 255) >> 8; // Rounded up, so the sum can't carry
+        uint32_t rest = 256 - coverage;
+
+        uint32_t low = ((((over & 0x00ff00ff) * opacity) >> 8) & 0x00ff00ff) + ((((pixel & 0x00ff00ff) * rest) >> 8) & 0x00ff00ff);
+        uint32_t high = ((((over >> 8) & 0x00ff00ff) * opacity) & 0xff00ff00) + ((((pixel >> 8) & 0x00ff00ff) * rest) & 0xff00ff00);
+
+        return low | high;
+    }
+
+    /**
+     * Hands out a reusable surface of at least w by h pixels in the given format, sizes are rounded up
+     * to multiples of SCRATCH_GRANULARITY so the pool settles on a few common ones.
+     * Only the top left w by h area is meant to be used. Give it back with release().
+     */
+    static SDL_Surface* scratch(uint16_t w, uint16_t h, SDL_PixelFormat* format);
+    static void release(SDL_Surface* surface);
+
+    static const uint16_t SCRATCH_GRANULARITY = 64;
+};
+
+#endif // BLITTER_H
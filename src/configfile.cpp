@@ -170,6 +170,25 @@ void config_file::fill() {
 
 	insert_missing("surface_alpha", "true");
 
+	insert_missing("cache_budget", "64"); // In megabytes
+
+	insert_missing("archive", "files.faa");
+	insert_missing("pixel_cache", "cache");
+
+	insert_missing("atlas", "true");
+	insert_missing("atlas_size", "512");
+	insert_missing("atlas_image_size", "96");
+
+	insert_missing("worker_threads", "0"); // 0 for one per core
+
+	insert_missing("frame_arena", "64"); // In kilobytes
+
+	insert_missing("profile", "false");
+	insert_missing("profile_graph", "false");
+	insert_missing("profile_trace", "trace.json"); // Written on exit if profiling
+
+	insert_missing("stats_log", ""); // CSV file, empty for none
+
 	insert_missing("window_title", "Engine");
 
 	insert_missing("font", "files/fonts/FreeSerif.ttf");
@@ -177,6 +196,10 @@ void config_file::fill() {
 	insert_missing("font_skip", "14");
 
 	insert_missing("sound", "true");
+	insert_missing("audio_rate", "44100");
+	insert_missing("audio_buffer", "1024"); // Sample frames, sounds start within one of these
+	insert_missing("audio_voices", "32"); // Sounds playing at once
+	insert_missing("sample_budget", "16"); // In megabytes
 
 	insert_missing("key_activate", "32");
 }
@@ -30,6 +30,10 @@
 #include "eventhandler.h"
 #include "tclbind.h"
 
+event_handler::event_handler() {
+	m_raw_motion = false;
+}
+
 bool event_handler::handle(controller_press_event*) {
 	return PASS;
 }
@@ -61,3 +65,11 @@ void event_handler::active(bool value) {
 void event_handler::bind(tcl_bind* bind) {
 	m_bind = bind;
 }
+
+bool event_handler::raw_motion() const {
+	return m_raw_motion;
+}
+
+void event_handler::raw_motion(bool value) {
+	m_raw_motion = value;
+}
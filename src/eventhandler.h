@@ -43,6 +43,7 @@ class tcl_bind;
 class event_handler {
 private:
     bool m_active;
+    bool m_raw_motion;
 
     tcl_bind* m_bind;
 protected:
@@ -60,6 +61,8 @@ public:
     static const bool END = true;
     static const bool PASS = false;
 
+    event_handler();
+
     template<class E>
     bool handle_abstract(E event) {
         if(m_active) {
@@ -73,6 +76,12 @@ public:
 
     void active(bool value);
 
+    /**
+     * Whether to get every mouse motion sample as it comes instead of one summed up move per frame.
+     */
+    bool raw_motion() const;
+    void raw_motion(bool value);
+
     void bind(tcl_bind* tcl_bind);
 };
 
@@ -33,7 +33,74 @@
 
 #include "gfx/controllablesprite.h"
 
+event_queue::event_queue() {
+	m_dispatched = 0;
+
+	m_motion_pending = false;
+}
+
+void event_queue::handle(pointer_move_event* event, bool raw) {
+	m_dispatched++;
+
+	for(
+		std::vector<event_handler*>::reverse_iterator iter = handlers.rbegin();
+		iter != handlers.rend();
+		iter++
+	) {
+		if((*iter)->raw_motion() != raw)
+			continue;
+
+		if((*iter)->handle_abstract(event))
+			break;
+	}
+}
+
 void event_queue::register_handler(event_handler* handler) {
 	handlers.push_back(handler);
 }
 
+static int16_t saturate(int32_t value) {
+	return value < -32768 ? -32768 : (value > 32767 ? 32767 : value);
+}
+
+void event_queue::coalesce(const SDL_Event& motion) {
+	if(!m_motion_pending) {
+		m_motion = motion;
+		m_motion_pending = true;
+		return;
+	}
+
+	m_motion.motion.state = motion.motion.state;
+	m_motion.motion.x = motion.motion.x;
+	m_motion.motion.y = motion.motion.y;
+	m_motion.motion.xrel = saturate(m_motion.motion.xrel + motion.motion.xrel);
+	m_motion.motion.yrel = saturate(m_motion.motion.yrel + motion.motion.yrel);
+}
+
+bool event_queue::coalesced(SDL_Event& motion) {
+	if(!m_motion_pending)
+		return false;
+
+	motion = m_motion;
+	m_motion_pending = false;
+
+	return true;
+}
+
+bool event_queue::raw_handlers() const {
+	for(
+		std::vector<event_handler*>::const_iterator iter = handlers.begin();
+		iter != handlers.end();
+		iter++
+	) {
+		if((*iter)->raw_motion())
+			return true;
+	}
+
+	return false;
+}
+
+uint32_t event_queue::dispatched() const {
+	return m_dispatched;
+}
+
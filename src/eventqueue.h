@@ -31,19 +31,30 @@
 #define EVENTQUEUE_H
 
 #include <vector>
+#include <stdint.h>
 
 #include "events/event.h"
 #include "eventhandler.h"
 
 #include "events/controllerpressevent.h"
 #include "events/controllerreleaseevent.h"
+#include "events/pointermoveevent.h"
 
 class event_queue {
 private:
     std::vector<event_handler*> handlers;
+
+    uint32_t m_dispatched;
+
+    SDL_Event m_motion; // Everything moved since the last flush, summed up
+    bool m_motion_pending;
 public:
+    event_queue();
+
     template<class T>
     void handle(T* event) {
+        m_dispatched++;
+
         for(
 		std::vector<event_handler*>::reverse_iterator iter = handlers.rbegin(); // Iterate in reverse to get last created sprites first
 		iter != handlers.rend();
@@ -54,7 +65,32 @@ public:
 	}
     }
 
+    /**
+     * Hands a move event only to the handlers that want raw motion, or only to the others.
+     */
+    void handle(pointer_move_event* event, bool raw);
+
     void register_handler(event_handler* handler);
+
+    /**
+     * Adds a mouse motion sample to the one move per frame: relative motion is summed up, the latest position and buttons win.
+     */
+    void coalesce(const SDL_Event& motion);
+
+    /**
+     * Takes the summed up motion, false if there was none since the last time.
+     */
+    bool coalesced(SDL_Event& motion);
+
+    /**
+     * Whether any handler wants raw motion, so samples don't need to be turned into events otherwise.
+     */
+    bool raw_handlers() const;
+
+    /**
+     * Events handed to the handlers so far.
+     */
+    uint32_t dispatched() const;
 };
 
 #endif // EVENTQUEUE_H
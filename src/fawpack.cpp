@@ -0,0 +1,72 @@
+/*
+	Copyright (c) 2010, Markus Wagner (bgld)
+	All rights reserved.
+
+	Redistribution and use in source and binary forms, with or without
+	modification, are permitted provided that the following conditions are
+	met:
+	- Redistributions of source code must retain the above copyright
+	  notice, this list of conditions and the following disclaimer.
+	- Redistributions in binary form must reproduce the above copyright
+	  notice, this list of conditions and the following disclaimer in the
+	  documentation and/or other materials provided with the distribution.
+	- Neither the name "fawesome" or "FawesomeEngine" nor the names of its contributors
+	  may be used to endorse or promote products derived from this software
+	  without specific prior written permission.
+
+	THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+	"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+	LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+	PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL MARKUS WAGNER BE
+	LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+	CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+	SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+	INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+	CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+	ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+	THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <stdexcept>
+#include <stdlib.h>
+#include <string.h>
+
+#include "archive.h"
+
+// Packs asset files into an archive the engine maps at startup, e.g.
+//	fawpack -d files.faa files/img/*.png files/img/chars/*.png
+
+int main(int argc, char* argv[]) {
+	bool decode = false;
+	int first = 1;
+
+	if(argc > 1 && strcmp(argv[1], "-d") == 0) {
+		decode = true;
+		first++;
+	}
+
+	if(argc - first < 2) {
+		std::cerr << "Usage: " << argv[0] << " [-d] archive file..." << std::endl;
+		std::cerr << "  -d  store images as decoded 32 bit pixels" << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	std::vector<std::string> names;
+
+	for(int i = first + 1; i < argc; i++)
+		names.push_back(argv[i]);
+
+	try {
+		asset_archive::build(argv[first], names, decode);
+	} catch(std::runtime_error e) {
+		std::cerr << e.what() << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	std::cout << "Packed " << names.size() << " files into " << argv[first] << std::endl;
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,97 @@
+/*
+	Copyright (c) 2010, Markus Wagner (bgld)
+	All rights reserved.
+
+	Redistribution and use in source and binary forms, with or without
+	modification, are permitted provided that the following conditions are
+	met:
+	- Redistributions of source code must retain the above copyright
+	  notice, this list of conditions and the following disclaimer.
+	- Redistributions in binary form must reproduce the above copyright
+	  notice, this list of conditions and the following disclaimer in the
+	  documentation and/or other materials provided with the distribution.
+	- Neither the name "fawesome" or "FawesomeEngine" nor the names of its contributors
+	  may be used to endorse or promote products derived from this software
+	  without specific prior written permission.
+
+	THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+	"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+	LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+	PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL MARKUS WAGNER BE
+	LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+	CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+	SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+	INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+	CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+	ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+	THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "framearena.h"
+
+#include <new>
+
+frame_arena::frame_arena(uint32_t capacity) {
+	m_capacity = capacity;
+	m_used = 0;
+	overflow_bytes = 0;
+
+	block = new uint8_t[m_capacity];
+}
+
+frame_arena::~frame_arena() {
+	reset();
+
+	delete[] block;
+}
+
+void* frame_arena::allocate(uint32_t bytes) {
+	bytes = (bytes + 7) & ~7;
+
+	if(m_used + bytes > m_capacity) {
+		uint8_t* extra = new uint8_t[bytes];
+
+		overflow.push_back(extra);
+		overflow_bytes += bytes;
+
+		return extra;
+	}
+
+	void* memory = block + m_used;
+	m_used += bytes;
+
+	return memory;
+}
+
+void frame_arena::reset() {
+	if(!overflow.empty()) {
+		for(
+			std::vector<uint8_t*>::iterator iter = overflow.begin();
+			iter != overflow.end();
+			iter++
+		) {
+			delete[] (*iter);
+		}
+
+		overflow.clear();
+
+		// Grow to what the last frame needed
+
+		delete[] block;
+
+		m_capacity += overflow_bytes;
+		block = new uint8_t[m_capacity];
+
+		overflow_bytes = 0;
+	}
+
+	m_used = 0;
+}
+
+uint32_t frame_arena::used() const {
+	return m_used;
+}
+
+uint32_t frame_arena::capacity() const {
+	return m_capacity;
+}
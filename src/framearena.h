@@ -0,0 +1,131 @@
+/*
+        Copyright (c) 2010, Markus Wagner (bgld)
+        All rights reserved.
+
+        Redistribution and use in source and binary forms, with or without
+        modification, are permitted provided that the following conditions are
+        met:
+        - Redistributions of source code must retain the above copyright
+          notice, this list of conditions and the following disclaimer.
+        - Redistributions in binary form must reproduce the above copyright
+          notice, this list of conditions and the following disclaimer in the
+          documentation and/or other materials provided with the distribution.
+        - Neither the name "fawesome" or "FawesomeEngine" nor the names of its contributors
+          may be used to endorse or promote products derived from this software
+          without specific prior written permission.
+
+        THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+        "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+        LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+        PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL MARKUS WAGNER BE
+        LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+        CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+        SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+        INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+        CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+        ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+        THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef FRAMEARENA_H
+#define FRAMEARENA_H
+
+#include <vector>
+#include <cstddef>
+#include <stdint.h>
+
+
+/**
+ * Bump allocator for data that only lives during one frame, everything is dropped at once by reset().
+ * Requests that don't fit go to the heap and the block grows by that much on the next reset,
+ * so after a few frames the arena is big enough and a frame allocates nothing.
+ */
+class frame_arena {
+private:
+    uint8_t* block;
+    uint32_t m_capacity;
+    uint32_t m_used;
+
+    std::vector<uint8_t*> overflow;
+    uint32_t overflow_bytes;
+public:
+    frame_arena(uint32_t capacity);
+    ~frame_arena();
+
+    /**
+     * Returns 8 byte aligned memory valid until the next reset.
+     */
+    void* allocate(uint32_t bytes);
+
+    void reset();
+
+    uint32_t used() const;
+    uint32_t capacity() const;
+};
+
+/**
+ * Standard allocator on top of a frame_arena, for containers that are built and thrown away within a frame.
+ * Deallocation does nothing, memory only comes back with the arena's reset.
+ */
+template<class T>
+class arena_allocator {
+public:
+    typedef T value_type;
+    typedef T* pointer;
+    typedef const T* const_pointer;
+    typedef T& reference;
+    typedef const T& const_reference;
+    typedef std::size_t size_type;
+    typedef std::ptrdiff_t difference_type;
+
+    template<class U>
+    struct rebind {
+        typedef arena_allocator<U> other;
+    };
+
+    frame_arena* arena;
+
+    arena_allocator(frame_arena* arena) : arena(arena) {}
+
+    template<class U>
+    arena_allocator(const arena_allocator<U>& other) : arena(other.arena) {}
+
+    pointer address(reference value) const {
+        return &value;
+    }
+
+    const_pointer address(const_reference value) const {
+        return &value;
+    }
+
+    pointer allocate(size_type count, const void* = 0) {
+        return (pointer)arena->allocate(count * sizeof(T));
+    }
+
+    void deallocate(pointer, size_type) {
+    }
+
+    size_type max_size() const {
+        return 0xffffffff / sizeof(T);
+    }
+
+    void construct(pointer place, const T& value) {
+        new((void*)place) T(value);
+    }
+
+    void destroy(pointer place) {
+        place->~T();
+    }
+
+    template<class U>
+    bool operator==(const arena_allocator<U>& other) const {
+        return arena == other.arena;
+    }
+
+    template<class U>
+    bool operator!=(const arena_allocator<U>& other) const {
+        return arena != other.arena;
+    }
+};
+
+#endif // FRAMEARENA_H
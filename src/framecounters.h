@@ -0,0 +1,78 @@
+/*
+        Copyright (c) 2010, Markus Wagner (bgld)
+        All rights reserved.
+
+        Redistribution and use in source and binary forms, with or without
+        modification, are permitted provided that the following conditions are
+        met:
+        - Redistributions of source code must retain the above copyright
+          notice, this list of conditions and the following disclaimer.
+        - Redistributions in binary form must reproduce the above copyright
+          notice, this list of conditions and the following disclaimer in the
+          documentation and/or other materials provided with the distribution.
+        - Neither the name "fawesome" or "FawesomeEngine" nor the names of its contributors
+          may be used to endorse or promote products derived from this software
+          without specific prior written permission.
+
+        THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+        "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+        LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+        PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL MARKUS WAGNER BE
+        LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+        CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+        SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+        INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+        CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+        ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+        THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef FRAMECOUNTERS_H
+#define FRAMECOUNTERS_H
+
+#include <stdint.h>
+#include <SDL/SDL.h>
+
+
+/**
+ * What the renderer did during one frame, filled in by the sprites and the screen.
+ */
+struct frame_counters {
+    uint32_t blits;
+    uint32_t pixels; // Blitted, after clipping
+    uint32_t culled;
+    uint32_t surfaces_created;
+    uint32_t surfaces_freed;
+    uint32_t obstruction_tests;
+
+    frame_counters() {
+        reset();
+    }
+
+    void reset() {
+        blits = 0;
+        pixels = 0;
+        culled = 0;
+        surfaces_created = 0;
+        surfaces_freed = 0;
+        obstruction_tests = 0;
+    }
+
+    void blit(const SDL_Rect& rect) {
+        blits++;
+        pixels += rect.w * rect.h;
+    }
+
+    frame_counters& operator+=(const frame_counters& other) {
+        blits += other.blits;
+        pixels += other.pixels;
+        culled += other.culled;
+        surfaces_created += other.surfaces_created;
+        surfaces_freed += other.surfaces_freed;
+        obstruction_tests += other.obstruction_tests;
+
+        return *this;
+    }
+};
+
+#endif // FRAMECOUNTERS_H
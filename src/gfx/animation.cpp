@@ -0,0 +1,348 @@
+/*
+	Copyright (c) 2010, Markus Wagner (bgld)
+	All rights reserved.
+
+	Redistribution and use in source and binary forms, with or without
+	modification, are permitted provided that the following conditions are
+	met:
+	- Redistributions of source code must retain the above copyright
+	  notice, this list of conditions and the following disclaimer.
+	- Redistributions in binary form must reproduce the above copyright
+	  notice, this list of conditions and the following disclaimer in the
+	  documentation and/or other materials provided with the distribution.
+	- Neither the name "fawesome" or "FawesomeEngine" nor the names of its contributors
+	  may be used to endorse or promote products derived from this software
+	  without specific prior written permission.
+
+	THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+	"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+	LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+	PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL MARKUS WAGNER BE
+	LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+	CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+	SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+	INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+	CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+	ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+	THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "animation.h"
+
+#include <sstream>
+#include <stdexcept>
+
+animation::animation(surface_cache* cache, const std::string& key) {
+	m_cache = cache;
+	m_key = key;
+
+	refs = 1;
+}
+
+animation::~animation() {
+	for(
+		std::vector<surface_region>::iterator iter = sources.begin();
+		iter != sources.end();
+		iter++
+	) {
+		m_cache->release(*iter);
+	}
+}
+
+const std::vector<surface_region>& animation::frames(int16_t dir) const {
+	static const std::vector<surface_region> none;
+
+	frame_map::const_iterator result = m_frames.find(dir);
+
+	return result != m_frames.end() ? result->second : none;
+}
+
+const file_map& animation::files() const {
+	return m_files;
+}
+
+bool animation::timed() const {
+	return !m_durations.empty();
+}
+
+uint16_t animation::frame_at(int16_t dir, uint32_t elapsed) const {
+	uint16_t count = frames(dir).size();
+
+	if(count == 0 || m_durations.empty())
+		return 0;
+
+	uint32_t period = 0;
+
+	for(uint16_t i = 0; i < count; i++)
+		period += m_durations[i % m_durations.size()];
+
+	if(period == 0)
+		return 0;
+
+	elapsed %= period;
+
+	for(uint16_t i = 0; i < count; i++) {
+		uint16_t duration = m_durations[i % m_durations.size()];
+
+		if(elapsed < duration)
+			return i;
+
+		elapsed -= duration;
+	}
+
+	return count - 1;
+}
+
+uint32_t animation::users() const {
+	return refs;
+}
+
+animation_registry::animation_registry(surface_cache* cache) {
+	m_cache = cache;
+}
+
+animation_registry::~animation_registry() {
+	for(
+		std::map<std::string, animation*>::iterator iter = templates.begin();
+		iter != templates.end();
+		iter++
+	) {
+		delete iter->second;
+	}
+}
+
+animation* animation_registry::derive(const animation* base, const std::string& key) {
+	// A copy of base holding its own references to the same images
+
+	animation* derived = new animation(m_cache, key);
+
+	if(base != NULL) {
+		derived->m_frames = base->m_frames;
+		derived->m_files = base->m_files;
+		derived->sources = base->sources;
+		derived->m_durations = base->m_durations;
+
+		for(
+			std::vector<surface_region>::iterator iter = derived->sources.begin();
+			iter != derived->sources.end();
+			iter++
+		) {
+			m_cache->retain(*iter);
+		}
+	}
+
+	return derived;
+}
+
+const animation* animation_registry::extend(const animation* base, int16_t dir, const std::string& file) {
+	return extend(base, file_list(1, std::make_pair(dir, file)));
+}
+
+const animation* animation_registry::extend(const animation* base, const file_list& files) {
+	std::stringstream key;
+
+	if(base != NULL)
+		key << base->m_key;
+
+	for(
+		file_list::const_iterator iter = files.begin();
+		iter != files.end();
+		iter++
+	) {
+		key << iter->first << ':' << iter->second << '\n';
+	}
+
+	std::map<std::string, animation*>::iterator result = templates.find(key.str());
+
+	if(result != templates.end()) {
+		result->second->refs++;
+		release(base);
+
+		return result->second;
+	}
+
+	// Nothing is built or registered for the steps in between
+
+	std::vector<surface_region> images;
+
+	try {
+		for(
+			file_list::const_iterator iter = files.begin();
+			iter != files.end();
+			iter++
+		) {
+			images.push_back(m_cache->fetch(iter->second));
+		}
+	} catch(...) {
+		for(
+			std::vector<surface_region>::iterator iter = images.begin();
+			iter != images.end();
+			iter++
+		) {
+			m_cache->release(*iter);
+		}
+
+		throw;
+	}
+
+	animation* extended = derive(base, key.str());
+
+	for(uint32_t i = 0; i < files.size(); i++) {
+		extended->sources.push_back(images[i]);
+		extended->m_frames[files[i].first].push_back(images[i]);
+		extended->m_files[files[i].first].push_back(files[i].second);
+	}
+
+	templates.insert(std::make_pair(key.str(), extended));
+
+	release(base);
+
+	return extended;
+}
+
+const animation* animation_registry::extend(const animation* base, int16_t dir, const std::string& file, uint16_t frame_w, uint16_t frame_h, const std::vector<uint16_t>& cells) {
+	if(frame_w == 0 || frame_h == 0)
+		throw std::runtime_error("Sheet cells need a size");
+
+	std::stringstream key;
+
+	if(base != NULL)
+		key << base->m_key;
+
+	key << dir << ':' << file << '@' << frame_w << 'x' << frame_h << ':';
+
+	for(
+		std::vector<uint16_t>::const_iterator iter = cells.begin();
+		iter != cells.end();
+		iter++
+	) {
+		key << *iter << ',';
+	}
+
+	key << '\n';
+
+	std::map<std::string, animation*>::iterator result = templates.find(key.str());
+
+	if(result != templates.end()) {
+		result->second->refs++;
+		release(base);
+
+		return result->second;
+	}
+
+	surface_region sheet = m_cache->fetch(file);
+
+	uint16_t columns = sheet.rect.w / frame_w;
+	uint16_t rows = sheet.rect.h / frame_h;
+
+	std::vector<uint16_t> used = cells;
+
+	if(used.empty()) {
+		for(uint16_t i = 0; i < columns * rows; i++)
+			used.push_back(i);
+	}
+
+	for(
+		std::vector<uint16_t>::iterator iter = used.begin();
+		iter != used.end();
+		iter++
+	) {
+		if(*iter >= columns * rows) {
+			m_cache->release(sheet);
+			throw std::runtime_error("Sheet cell out of range in " + file);
+		}
+	}
+
+	animation* extended = derive(base, key.str());
+
+	extended->sources.push_back(sheet);
+
+	for(
+		std::vector<uint16_t>::iterator iter = used.begin();
+		iter != used.end();
+		iter++
+	) {
+		surface_region cell = sheet;
+
+		cell.rect.x += (*iter % columns) * frame_w;
+		cell.rect.y += (*iter / columns) * frame_h;
+		cell.rect.w = frame_w;
+		cell.rect.h = frame_h;
+
+		extended->m_frames[dir].push_back(cell);
+	}
+
+	std::stringstream description;
+	description << file << '@' << frame_w << 'x' << frame_h;
+
+	extended->m_files[dir].push_back(description.str());
+
+	templates.insert(std::make_pair(key.str(), extended));
+
+	release(base);
+
+	return extended;
+}
+
+const animation* animation_registry::single(int16_t dir, const surface_region& region) {
+	animation* result = new animation(m_cache, "");
+
+	result->m_frames[dir].push_back(region);
+
+	return result;
+}
+
+const animation* animation_registry::timed(const animation* base, const std::vector<uint16_t>& durations) {
+	if(base == NULL || base->m_key.empty())
+		throw std::runtime_error("Only shared animations can be timed");
+
+	std::stringstream key;
+	key << base->m_key << '@';
+
+	for(
+		std::vector<uint16_t>::const_iterator iter = durations.begin();
+		iter != durations.end();
+		iter++
+	) {
+		key << *iter << ',';
+	}
+
+	key << '\n';
+
+	std::map<std::string, animation*>::iterator result = templates.find(key.str());
+
+	if(result != templates.end()) {
+		result->second->refs++;
+		release(base);
+
+		return result->second;
+	}
+
+	animation* clip = derive(base, key.str());
+	clip->m_durations = durations;
+
+	templates.insert(std::make_pair(key.str(), clip));
+
+	release(base);
+
+	return clip;
+}
+
+void animation_registry::release(const animation* shared) {
+	if(shared == NULL)
+		return;
+
+	animation* victim = const_cast<animation*>(shared);
+
+	if(--victim->refs > 0)
+		return;
+
+	if(!victim->m_key.empty())
+		templates.erase(victim->m_key);
+
+	delete victim;
+}
+
+uint32_t animation_registry::count() const {
+	return templates.size();
+}
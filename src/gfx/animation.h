@@ -0,0 +1,138 @@
+/*
+        Copyright (c) 2010, Markus Wagner (bgld)
+        All rights reserved.
+
+        Redistribution and use in source and binary forms, with or without
+        modification, are permitted provided that the following conditions are
+        met:
+        - Redistributions of source code must retain the above copyright
+          notice, this list of conditions and the following disclaimer.
+        - Redistributions in binary form must reproduce the above copyright
+          notice, this list of conditions and the following disclaimer in the
+          documentation and/or other materials provided with the distribution.
+        - Neither the name "fawesome" or "FawesomeEngine" nor the names of its contributors
+          may be used to endorse or promote products derived from this software
+          without specific prior written permission.
+
+        THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+        "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+        LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+        PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL MARKUS WAGNER BE
+        LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+        CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+        SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+        INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+        CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+        ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+        THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef ANIMATION_H
+#define ANIMATION_H
+
+#include <map>
+#include <vector>
+#include <string>
+#include <stdint.h>
+
+#include "../surfacecache.h"
+
+
+typedef std::map<int16_t, std::vector<surface_region> > frame_map;
+typedef std::map<int16_t, std::vector<std::string> > file_map;
+typedef std::vector<std::pair<int16_t, std::string> > file_list; // Direction and file, in push order
+
+/**
+ * Immutable set of frames per direction, shared by all sprites showing the same images.
+ * Frames are regions of the loaded images, either whole files or cells of a sprite sheet.
+ * Instances come from the animation_registry and are reference counted there.
+ */
+class animation {
+    friend class animation_registry;
+private:
+    std::string m_key; // Empty for private ones that aren't shared
+
+    frame_map m_frames;
+    file_map m_files;
+
+    std::vector<surface_region> sources; // As fetched from the cache, frames may be parts of them
+
+    std::vector<uint16_t> m_durations; // Milliseconds per frame, repeated if shorter than a direction's frames
+
+    uint32_t refs;
+
+    surface_cache* m_cache;
+
+    animation(surface_cache* cache, const std::string& key);
+    ~animation();
+public:
+    /**
+     * The frames for a direction, empty if there are none.
+     */
+    const std::vector<surface_region>& frames(int16_t dir) const;
+
+    const file_map& files() const;
+
+    /**
+     * Whether frames have durations, i.e. the animation runs on the clock instead of counting frames.
+     */
+    bool timed() const;
+
+    /**
+     * The frame of dir showing after elapsed milliseconds, looping.
+     */
+    uint16_t frame_at(int16_t dir, uint32_t elapsed) const;
+
+    uint32_t users() const;
+};
+
+/**
+ * Hands out shared animations keyed by the sequence of files pushed into them.
+ * Pushing a file onto an animation yields the animation with that file added, so sprites
+ * built with the same push_file calls end up with the same instance.
+ */
+class animation_registry {
+private:
+    surface_cache* m_cache;
+
+    std::map<std::string, animation*> templates;
+public:
+    animation_registry(surface_cache* cache);
+    ~animation_registry();
+
+    /**
+     * Returns base with file added to the frames of dir and drops the caller's reference to base.
+     * base may be NULL to start a new one.
+     */
+    const animation* extend(const animation* base, int16_t dir, const std::string& file);
+
+    /**
+     * Like extend with a single file, but adds all files at once and registers only the result,
+     * the same instance as pushing them one by one would end with.
+     */
+    const animation* extend(const animation* base, const file_list& files);
+
+    /**
+     * Like extend, but adds cells of a sheet made of frame_w by frame_h cells, counted row by row from 0.
+     * All cells in order if cells is empty. The sheet is loaded once and every frame is a part of it.
+     */
+    const animation* extend(const animation* base, int16_t dir, const std::string& file, uint16_t frame_w, uint16_t frame_h, const std::vector<uint16_t>& cells);
+
+    /**
+     * A private one frame animation around a region the caller owns, not shared with anyone.
+     */
+    const animation* single(int16_t dir, const surface_region& region);
+
+    /**
+     * Returns base with the given frame durations in milliseconds and drops the caller's reference to base.
+     */
+    const animation* timed(const animation* base, const std::vector<uint16_t>& durations);
+
+    void release(const animation* shared);
+
+    uint32_t count() const;
+private:
+    animation* derive(const animation* base, const std::string& key);
+};
+
+#endif // ANIMATION_H
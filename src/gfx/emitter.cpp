@@ -0,0 +1,338 @@
+/*
+	Copyright (c) 2010, Markus Wagner (bgld)
+	All rights reserved.
+
+	Redistribution and use in source and binary forms, with or without
+	modification, are permitted provided that the following conditions are
+	met:
+	- Redistributions of source code must retain the above copyright
+	  notice, this list of conditions and the following disclaimer.
+	- Redistributions in binary form must reproduce the above copyright
+	  notice, this list of conditions and the following disclaimer in the
+	  documentation and/or other materials provided with the distribution.
+	- Neither the name "fawesome" or "FawesomeEngine" nor the names of its contributors
+	  may be used to endorse or promote products derived from this software
+	  without specific prior written permission.
+
+	THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+	"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+	LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+	PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL MARKUS WAGNER BE
+	LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+	CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+	SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+	INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+	CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+	ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+	THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "emitter.h"
+
+#include <stdexcept>
+
+#include "scenegraph.h"
+
+
+// Longest step taken at once, so a stall doesn't turn into one big burst
+static const float MAX_STEP = 0.1f;
+
+emitter::emitter(SDL_Surface* screen, SDL_Surface* background, surface_cache* cache, const std::string &file) : sprite(screen, background, cache, file) {
+	m_count = 0;
+
+	m_rate = 0;
+	m_spawn_debt = 0;
+
+	m_life_time = 1;
+	m_life_spread = 0;
+	m_velocity_x = m_velocity_y = m_spread_x = m_spread_y = 0;
+	m_accel_x = m_accel_y = 0;
+	m_fade_in = m_fade_out = 0;
+	m_area_w = m_area_h = 0;
+
+	m_last_time = 0;
+	m_started = false;
+
+	m_seed = (uint32_t)(uintptr_t)this;
+
+	m_faded_region.surface = NULL;
+
+	capacity(DEFAULT_CAPACITY);
+
+	// Particles may fly anywhere, and need stepping every frame
+
+	check_bounds(false);
+	state().always_awake[node()] = 1;
+}
+
+emitter::~emitter() {
+	free_fades();
+}
+
+float emitter::random() {
+	m_seed = m_seed * 1664525 + 1013904223;
+
+	return ((m_seed >> 16) & 0x7fff) / 16383.5f - 1;
+}
+
+void emitter::calculate() {
+	sprite::calculate();
+
+	uint32_t now = graph()->time();
+
+	if(!m_started) {
+		m_last_time = now;
+		m_started = true;
+	}
+
+	float seconds = (now - m_last_time) / 1000.0f;
+	m_last_time = now;
+
+	if(seconds > MAX_STEP)
+		seconds = MAX_STEP;
+
+	step(seconds);
+
+	m_spawn_debt += m_rate * seconds;
+
+	uint32_t spawned = (uint32_t)m_spawn_debt;
+	m_spawn_debt -= spawned;
+
+	burst(spawned);
+}
+
+void emitter::step(float seconds) {
+	if(m_count == 0)
+		return;
+
+	float* x = &m_x[0];
+	float* y = &m_y[0];
+	float* vx = &m_vx[0];
+	float* vy = &m_vy[0];
+	float* age = &m_age[0];
+
+	float dvx = m_accel_x * seconds;
+	float dvy = m_accel_y * seconds;
+
+	// Straight arithmetic over plain arrays, nothing in here keeps the compiler from vectorizing it
+
+	for(uint32_t i = 0; i < m_count; i++) {
+		vx[i] += dvx;
+		vy[i] += dvy;
+		x[i] += vx[i] * seconds;
+		y[i] += vy[i] * seconds;
+		age[i] += seconds;
+	}
+
+	// The dead make room by taking the last particle, order doesn't matter as they're never sorted
+
+	float* life = &m_life[0];
+
+	for(uint32_t i = 0; i < m_count;) {
+		if(age[i] < life[i]) {
+			i++;
+			continue;
+		}
+
+		m_count--;
+
+		x[i] = x[m_count];
+		y[i] = y[m_count];
+		vx[i] = vx[m_count];
+		vy[i] = vy[m_count];
+		age[i] = age[m_count];
+		life[i] = life[m_count];
+	}
+}
+
+void emitter::burst(uint32_t particles) {
+	uint32_t end = m_count + particles;
+
+	if(end > m_x.size())
+		end = m_x.size();
+
+	for(uint32_t i = m_count; i < end; i++) {
+		m_x[i] = (random() + 1) / 2 * m_area_w;
+		m_y[i] = (random() + 1) / 2 * m_area_h;
+		m_vx[i] = m_velocity_x + random() * m_spread_x;
+		m_vy[i] = m_velocity_y + random() * m_spread_y;
+		m_age[i] = 0;
+		m_life[i] = m_life_time + random() * m_life_spread;
+	}
+
+	m_count = end;
+}
+
+void emitter::display() {
+	uint8_t alpha = this->alpha();
+
+	if(!has_region() || m_count == 0 || alpha == SDL_ALPHA_TRANSPARENT)
+		return;
+
+	const surface_region& source = region();
+
+	if(
+		m_faded_region.surface != source.surface ||
+		m_faded_region.rect.x != source.rect.x ||
+		m_faded_region.rect.y != source.rect.y ||
+		m_faded_region.rect.w != source.rect.w ||
+		m_faded_region.rect.h != source.rect.h
+	) {
+		fade_levels(source);
+	}
+
+	frame_counters* counters = stats();
+
+	int32_t origin_x = display_x();
+	int32_t origin_y = display_y();
+	int32_t w = source.rect.w;
+	int32_t h = source.rect.h;
+
+	float opacity = alpha / 255.0f * FADE_LEVELS;
+
+	for(uint32_t i = 0; i < m_count; i++) {
+		int32_t disp_x = origin_x + (int32_t)m_x[i];
+		int32_t disp_y = origin_y + (int32_t)m_y[i];
+
+		if(disp_x + w <= 0 || disp_y + h <= 0 || disp_x >= m_screen->w || disp_y >= m_screen->h) {
+			counters->culled++;
+			continue;
+		}
+
+		// Fading in and out at the same time takes whichever is further from opaque
+
+		float age = m_age[i];
+		float left = m_life[i] - age;
+		float level = opacity;
+
+		if(age < m_fade_in)
+			level = opacity * age / m_fade_in;
+
+		if(left < m_fade_out && opacity * left / m_fade_out < level)
+			level = opacity * left / m_fade_out;
+
+		uint16_t fade = (uint16_t)(level + 0.5f);
+
+		if(fade == 0)
+			continue;
+
+		SDL_Rect dest_rect = {(Sint16)disp_x, (Sint16)disp_y, (Uint16)w, (Uint16)h}; // Culled above, so it fits
+
+		SDL_BlitSurface(m_fades[fade - 1], NULL, m_screen, &dest_rect);
+		counters->blit(dest_rect);
+	}
+}
+
+void emitter::fade_levels(const surface_region& source) {
+	free_fades();
+
+	frame_counters* counters = stats();
+	SDL_Surface* source_view = view(source);
+
+	for(uint16_t level = 1; level <= FADE_LEVELS; level++) {
+		SDL_Surface* faded = SDL_DisplayFormatAlpha(source_view);
+
+		if(faded == NULL)
+			throw std::runtime_error("Couldn't convert particle surface");
+
+		counters->surfaces_created++;
+
+		// Scale the alpha channel, every pixel is 4 bytes after the conversion
+
+		uint32_t amask = faded->format->Amask;
+		uint8_t ashift = faded->format->Ashift;
+
+		SDL_LockSurface(faded);
+
+		for(int16_t y = 0; y < faded->h; y++) {
+			uint32_t* pixel = (uint32_t*)((uint8_t*)faded->pixels + y * faded->pitch);
+
+			for(int16_t x = 0; x < faded->w; x++) {
+				uint32_t a = ((pixel[x] & amask) >> ashift) * level / FADE_LEVELS;
+				pixel[x] = (pixel[x] & ~amask) | (a << ashift);
+			}
+		}
+
+		SDL_UnlockSurface(faded);
+
+		m_fades.push_back(faded);
+	}
+
+	if(source_view != source.surface) {
+		SDL_FreeSurface(source_view);
+
+		counters->surfaces_created++;
+		counters->surfaces_freed++;
+	}
+
+	m_faded_region = source;
+}
+
+void emitter::free_fades() {
+	for(
+		std::vector<SDL_Surface*>::iterator iter = m_fades.begin();
+		iter != m_fades.end();
+		iter++
+	) {
+		SDL_FreeSurface(*iter);
+		stats()->surfaces_freed++;
+	}
+
+	m_fades.clear();
+	m_faded_region.surface = NULL;
+}
+
+uint32_t emitter::count() const {
+	return m_count;
+}
+
+uint32_t emitter::capacity() const {
+	return m_x.size();
+}
+
+void emitter::capacity(uint32_t capacity) {
+	m_x.resize(capacity);
+	m_y.resize(capacity);
+	m_vx.resize(capacity);
+	m_vy.resize(capacity);
+	m_age.resize(capacity);
+	m_life.resize(capacity);
+
+	if(m_count > capacity)
+		m_count = capacity;
+}
+
+float emitter::rate() const {
+	return m_rate;
+}
+
+void emitter::rate(float rate) {
+	m_rate = rate;
+}
+
+void emitter::life(uint32_t life, uint32_t spread) {
+	m_life_time = life / 1000.0f;
+	m_life_spread = spread / 1000.0f;
+}
+
+void emitter::velocity(float x, float y, float spread_x, float spread_y) {
+	m_velocity_x = x;
+	m_velocity_y = y;
+	m_spread_x = spread_x;
+	m_spread_y = spread_y;
+}
+
+void emitter::acceleration(float x, float y) {
+	m_accel_x = x;
+	m_accel_y = y;
+}
+
+void emitter::area(uint16_t w, uint16_t h) {
+	m_area_w = w;
+	m_area_h = h;
+}
+
+void emitter::fade(uint32_t fade_in, uint32_t fade_out) {
+	m_fade_in = fade_in / 1000.0f;
+	m_fade_out = fade_out / 1000.0f;
+}
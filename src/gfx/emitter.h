@@ -0,0 +1,133 @@
+/*
+        Copyright (c) 2010, Markus Wagner (bgld)
+        All rights reserved.
+
+        Redistribution and use in source and binary forms, with or without
+        modification, are permitted provided that the following conditions are
+        met:
+        - Redistributions of source code must retain the above copyright
+          notice, this list of conditions and the following disclaimer.
+        - Redistributions in binary form must reproduce the above copyright
+          notice, this list of conditions and the following disclaimer in the
+          documentation and/or other materials provided with the distribution.
+        - Neither the name "fawesome" or "FawesomeEngine" nor the names of its contributors
+          may be used to endorse or promote products derived from this software
+          without specific prior written permission.
+
+        THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+        "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+        LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+        PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL MARKUS WAGNER BE
+        LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+        CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+        SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+        INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+        CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+        ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+        THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef EMITTER_H
+#define EMITTER_H
+
+#include <vector>
+
+#include "sprite.h"
+
+
+/**
+ * Sprite that spawns lots of small particles from its image, for weather and effects.
+ * The particles aren't objects of their own: they live in one array per attribute, are stepped in a single loop
+ * and blitted in another, and the whole emitter is sorted into the scene as one sprite.
+ * Positions are relative to the emitter, so an emitter following a map scrolls with it.
+ */
+class emitter : public sprite {
+private:
+    // Live particles are the first m_count entries, in pixels, pixels per second and seconds
+    std::vector<float> m_x, m_y;
+    std::vector<float> m_vx, m_vy;
+    std::vector<float> m_age, m_life;
+    uint32_t m_count;
+
+    float m_rate;
+    float m_spawn_debt; // Fractions of particles owed from previous frames
+
+    float m_life_time, m_life_spread;
+    float m_velocity_x, m_velocity_y, m_spread_x, m_spread_y;
+    float m_accel_x, m_accel_y;
+    float m_fade_in, m_fade_out;
+    uint16_t m_area_w, m_area_h;
+
+    uint32_t m_last_time;
+    bool m_started;
+
+    uint32_t m_seed;
+
+    // Copies of the particle image at rising opacity, SDL 1.2 can't fade per-pixel alpha surfaces while blitting
+    std::vector<SDL_Surface*> m_fades;
+    surface_region m_faded_region;
+
+    /**
+     * Uniformly distributed in [-1, 1].
+     */
+    float random();
+
+    void step(float seconds);
+    void fade_levels(const surface_region& source);
+    void free_fades();
+public:
+    emitter(SDL_Surface* screen, SDL_Surface* background, surface_cache* cache, const std::string &file);
+    virtual ~emitter();
+
+    void calculate();
+    void display();
+
+    /**
+     * Spawns particles right away, on top of the rate.
+     */
+    void burst(uint32_t particles);
+
+    uint32_t count() const;
+
+    /**
+     * How many particles can be alive at once, the ones alive beyond it are dropped.
+     */
+    uint32_t capacity() const;
+    void capacity(uint32_t capacity);
+
+    /**
+     * Particles spawned per second.
+     */
+    float rate() const;
+    void rate(float rate);
+
+    /**
+     * Lifetime of a particle in milliseconds, varying by up to spread either way.
+     */
+    void life(uint32_t life, uint32_t spread);
+
+    /**
+     * Starting velocity in pixels per second, varying by up to spread_x and spread_y either way.
+     */
+    void velocity(float x, float y, float spread_x, float spread_y);
+
+    /**
+     * Acceleration in pixels per second squared, for gravity and wind.
+     */
+    void acceleration(float x, float y);
+
+    /**
+     * Particles start anywhere within this area, from the emitter's position to the right and down.
+     */
+    void area(uint16_t w, uint16_t h);
+
+    /**
+     * Milliseconds a particle takes to fade in after spawning and to fade out before it dies, 0 for none.
+     */
+    void fade(uint32_t fade_in, uint32_t fade_out);
+
+    static const uint32_t DEFAULT_CAPACITY = 1024;
+    static const uint16_t FADE_LEVELS = 16;
+};
+
+#endif // EMITTER_H
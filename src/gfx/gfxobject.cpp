@@ -34,45 +34,35 @@
 #include "../globals.h"
 #include "layer.h"
 
-gfx_object::gfx_object() {
-	m_check_bounds = true;
-	m_coords_updated = false;
-
-	m_x_min = 0;
-	m_x_max = 0;
-	m_y_min = 0;
-	m_y_max = 0;
-
-	m_x = 0;
-	m_y = 0;
+scene_graph* gfx_object::scene = NULL;
 
-	m_target_x = 0;
-	m_target_y = 0;
-
-	m_offset_x = 0;
-	m_offset_y = 0;
-
-	m_speed_x = 0;
-	m_speed_y = 0;
+gfx_object::gfx_object() {
+	m_node = scene->create();
 
 	m_layer_id = layer::NO_ID;
+
+	m_camera = NULL;
 }
 
 gfx_object::~gfx_object() {
-	//dtor
+	if(scene != NULL)
+		scene->destroy(m_node);
 }
 
 void gfx_object::add_follower(gfx_object* sprite) {
-	//std::cout << "follower" << std::endl;
-	sprite->check_bounds(false);
+	attach(sprite, this, m_camera);
+
+	followers.push_back(sprite);
+}
 
-	sprite->offset_x(sprite->x());
-	sprite->offset_y(sprite->y());
+void gfx_object::attach(gfx_object* object, gfx_object* parent, camera* view) {
+	object->check_bounds(false);
 
-	sprite->x(0);
-	sprite->y(0);
+	scene->parent(object->m_node, parent != NULL ? parent->m_node : scene_graph::NO_NODE);
+	object->view(view);
 
-	followers.push_back(sprite);
+	object->x(0);
+	object->y(0);
 }
 
 void gfx_object::remove_follower(gfx_object* sprite) {
@@ -102,107 +92,115 @@ uint16_t gfx_object::obstructed(player* player) const {
 	return ret;
 }
 
-int16_t gfx_object::calculate_movement(int16_t coord, int16_t target, int16_t speed) const {
-	if(coord != target && speed != 0) {
-		int16_t tolerance = 2 * (target % speed);
+void gfx_object::calculate() {
+	// Movement is stepped for all objects at once in scene_graph::simulate
+}
 
-		for(int16_t i = -tolerance; i <= tolerance; i++) {
-			if(coord + i == target) {
-				coord = target;
-				break;
-			}
-		}
+void gfx_object::check_bounds(bool check_bounds) {
+	state().bounded[m_node] = check_bounds;
+}
 
-		return coord + speed;
-	}
+void gfx_object::bounds(int32_t x_min, int32_t x_max, int32_t y_min, int32_t y_max) {
+	node_state& state = this->state();
 
-	return coord;
+	state.x_min[m_node] = x_min;
+	state.x_max[m_node] = x_max;
+	state.y_min[m_node] = y_min;
+	state.y_max[m_node] = y_max;
 }
 
-void gfx_object::calculate() {
-	x(calculate_movement(m_x, m_target_x, m_speed_x));
-	y(calculate_movement(m_y, m_target_y, m_speed_y));
+int32_t gfx_object::x() const {
+	return scene->local_x(m_node);
+}
 
-	set_offsets();
+int32_t gfx_object::y() const {
+	return scene->local_y(m_node);
 }
 
-void gfx_object::set_offsets() {
-	for(
-		followers_queue::iterator iter = followers.begin();
-		iter != followers.end();
-		iter++
-	) {
-		int16_t iter_x = m_x + m_offset_x;
-		int16_t iter_y = m_y + m_offset_y;
+void gfx_object::x(int32_t x) {
+	node_state& state = this->state();
 
-		(*iter)->offset_x(iter_x);
-		(*iter)->offset_y(iter_y);
-		(*iter)->set_offsets();
+	if(state.bounded[m_node] && x < state.x_min[m_node]) {
+		x = state.x_min[m_node];
+	} else if(state.bounded[m_node] && x > state.x_max[m_node]) {
+		x = state.x_max[m_node];
 	}
-}
 
-void gfx_object::check_bounds(bool check_bounds) {
-	m_check_bounds = check_bounds;
-}
+	if(x != scene->local_x(m_node)) {
+		scene->local_x(m_node, x);
+		state.moved[m_node] = 1;
 
-int16_t gfx_object::x() const {
-	return m_x;
+		wake();
+	}
 }
 
-int16_t gfx_object::y() const {
-	return m_y;
-}
+void gfx_object::y(int32_t y) {
+	node_state& state = this->state();
+
+	if(state.bounded[m_node] && y < state.y_min[m_node]) {
+		y = state.y_min[m_node];
+	} else if(state.bounded[m_node] && y > state.y_max[m_node]) {
+		y = state.y_max[m_node];
+	}
 
-void gfx_object::x(int16_t x) {
-	m_coords_updated = true;
+	if(y != scene->local_y(m_node)) {
+		scene->local_y(m_node, y);
+		state.moved[m_node] = 1;
 
-	if(m_check_bounds && x < m_x_min) {
-		m_x = m_x_min;
-	} else if(m_check_bounds && x > m_x_max) {
-		m_x = m_x_max;
-	} else {
-		m_x = x;
+		wake();
 	}
 }
 
-void gfx_object::y(int16_t y) {
-	m_coords_updated = true;
+int32_t gfx_object::world_x() const {
+	return scene->world_x(m_node);
+}
 
-	if(m_check_bounds && y < m_y_min) {
-		m_y = m_y_min;
-	} else if(m_check_bounds && y > m_y_max) {
-		m_y = m_y_max;
-	} else {
-		m_y = y;
-	}
+int32_t gfx_object::world_y() const {
+	return scene->world_y(m_node);
+}
+
+int32_t gfx_object::display_x() const {
+	return m_camera != NULL ? world_x() - m_camera->x() : world_x();
 }
 
-int16_t gfx_object::offset_x() const {
-	return m_offset_x;
+int32_t gfx_object::display_y() const {
+	return m_camera != NULL ? world_y() - m_camera->y() : world_y();
+}
+
+camera* gfx_object::view() const {
+	return m_camera;
 }
 
-void gfx_object::offset_x(int16_t offset) {
-	//m_coords_updated = true;
+void gfx_object::view(camera* view) {
+	m_camera = view;
 
-	m_offset_x = offset;
+	for(
+		followers_queue::iterator iter = followers.begin();
+		iter != followers.end();
+		iter++
+	) {
+		(*iter)->view(view);
+	}
 }
 
-int16_t gfx_object::offset_y() const {
-	return m_offset_y;
+uint32_t gfx_object::node() const {
+	return m_node;
 }
 
-void gfx_object::offset_y(int16_t offset) {
-	//m_coords_updated = true;
+void gfx_object::wake() {
+	scene->wake(m_node);
+}
 
-	m_offset_y = offset;
+node_state& gfx_object::state() const {
+	return scene->state();
 }
 
-int32_t gfx_object::display_x() const {
-	return m_x + m_offset_x;
+scene_graph* gfx_object::graph() {
+	return scene;
 }
 
-int32_t gfx_object::display_y() const {
-	return m_y + m_offset_y;
+void gfx_object::graph(scene_graph* graph) {
+	scene = graph;
 }
 
 const uint16_t& gfx_object::layer_id() const {
@@ -210,7 +208,8 @@ const uint16_t& gfx_object::layer_id() const {
 }
 
 void gfx_object::layer_id(const uint16_t& layer_id) {
-	m_coords_updated = true;
+	state().moved[m_node] = 1;
+	wake();
 
 	m_layer_id = layer_id;
 }
@@ -33,6 +33,9 @@
 #include <vector>
 #include <stdint.h>
 
+#include "camera.h"
+#include "scenegraph.h"
+
 class gfx_object;
 class player;
 
@@ -43,7 +46,7 @@ public:
     gfx_object();
     virtual ~gfx_object();
 
-    void add_follower(gfx_object* object);
+    virtual void add_follower(gfx_object* object);
     void remove_follower(gfx_object* object);
 
     virtual uint16_t obstructed(player* player) const;
@@ -52,38 +55,63 @@ public:
 
     void check_bounds(bool check_bounds);
 
-    int16_t x() const;
-    void x(int16_t x);
-    int16_t y() const;
-    void y(int16_t y);
+    int32_t x() const;
+    void x(int32_t x);
+    int32_t y() const;
+    void y(int32_t y);
 
-    virtual int16_t offset_x() const;
-    virtual void offset_x(int16_t offset);
-    virtual int16_t offset_y() const;
-    virtual void offset_y(int16_t offset);
+    /**
+     * Position in world space, i.e. relative to the parent's world position if there is one.
+     */
+    int32_t world_x() const;
+    int32_t world_y() const;
 
+    /**
+     * Position on screen, world position minus camera position.
+     */
     int32_t display_x() const;
     int32_t display_y() const;
 
+    camera* view() const;
+    void view(camera* view);
+
+    uint32_t node() const;
+
+    /**
+     * The scene graph holding the transforms of all objects, owned by the screen.
+     */
+    static scene_graph* graph();
+    static void graph(scene_graph* graph);
+
     const uint16_t& layer_id() const;
     void layer_id(const uint16_t& layer);
 protected:
     followers_queue followers;
 
-    int16_t m_x, m_y, m_target_x, m_target_y;
-    int16_t m_speed_x, m_speed_y;
-    int16_t m_x_min, m_x_max, m_y_min, m_y_max;
-    int16_t m_offset_x, m_offset_y;
+    /**
+     * The hot state of all objects, index it with node().
+     */
+    node_state& state() const;
 
-    void set_offsets();
+    void bounds(int32_t x_min, int32_t x_max, int32_t y_min, int32_t y_max);
 
-    bool m_coords_updated;
-private:
-    bool m_check_bounds;
+    /**
+     * Has the object stepped by the next simulate() again, every setter that starts something calls this.
+     */
+    void wake();
 
+    /**
+     * Makes object a follower positioned relative to parent, parent may be NULL for world space.
+     * An object has only one transform parent, the latest one wins.
+     */
+    static void attach(gfx_object* object, gfx_object* parent, camera* view);
+private:
     uint16_t m_layer_id;
 
-    int16_t calculate_movement(int16_t coord, int16_t target, int16_t speed) const;
+    uint32_t m_node;
+    camera* m_camera;
+
+    static scene_graph* scene;
 };
 
 #endif // GFXOBJECT_H
@@ -58,8 +58,8 @@ public:
 		if(handler == NULL)
 			return;
 
-		int16_t handler_x = handler->display_x();
-		int16_t handler_y = handler->display_y();
+		int32_t handler_x = handler->display_x();
+		int32_t handler_y = handler->display_y();
 
 		if(
 			handler_x + handler->width() >= x &&
@@ -31,7 +31,6 @@
 
 #include <iostream>
 #include <stdexcept>
-#include <limits>
 #include <assert.h>
 #include <math.h>
 #include <SDL/SDL.h>
@@ -39,22 +38,24 @@
 #include "../globals.h"
 #include "player.h"
 #include "../tclbind.h"
+#include "../blitter.h"
+#include "../inputstate.h"
 
 map::map(SDL_Surface* screen, SDL_Surface* background, surface_cache* cache, tcl_bind* bind, const std::string &file, uint16_t width, uint16_t height) : controllable_sprite(screen, background, cache, file) {
 	m_bind = bind;
 
 	active(true);
 
-	if(width * (*surfaces_iter)->w < config->int_value("display_width") || height * (*surfaces_iter)->h < config->int_value("display_height"))
+	if(width * region().rect.w < config->int_value("display_width") || height * region().rect.h < config->int_value("display_height"))
 		throw std::runtime_error("Map too small.");
 
-	tile_width = (*surfaces_iter)->w;
-	tile_height = (*surfaces_iter)->h;
+	tile_width = region().rect.w;
+	tile_height = region().rect.h;
 
 	SDL_Rect dest;
 
 	map_background = SDL_CreateRGBSurface(
-		SDL_SWSURFACE | SDL_SRCALPHA | SDL_RLEACCEL,
+		SDL_SWSURFACE | SDL_SRCALPHA, // No RLE, it's copied row by row every frame
 		screen->w + tile_width,
 		screen->h + tile_height,
 		config->int_value("screen_bpp"),
@@ -67,20 +68,18 @@ map::map(SDL_Surface* screen, SDL_Surface* background, surface_cache* cache, tcl
 
 	dest.x = 0;
 	dest.y = 0;
-	dest.w = (*surfaces_iter)->w;
-	dest.h = (*surfaces_iter)->h;
-
-	// Prevent overflow
-	if(width * (*surfaces_iter)->w > std::numeric_limits<Sint16>::max())
-		throw std::runtime_error("Map too large.");
+	dest.w = region().rect.w;
+	dest.h = region().rect.h;
 
 	// We're filling the map in x direction first and then multiply the segment, this is much faster
 
-	Sint16 segment_length = (*surfaces_iter)->w;
+	int32_t segment_length = region().rect.w;
+
+	SDL_Rect tile_rect = region().rect;
 
-	SDL_BlitSurface((*surfaces_iter), NULL, map_background, NULL);
+	SDL_BlitSurface(region().surface, &tile_rect, map_background, NULL);
 
-	while(segment_length < width * (*surfaces_iter)->w) {
+	while(segment_length < map_background->w) {
 		dest.x = segment_length;
 
 		segment_length *= 2;
@@ -89,9 +88,9 @@ map::map(SDL_Surface* screen, SDL_Surface* background, surface_cache* cache, tcl
 	}
 
 	dest.x = 0;
-	segment_length = (*surfaces_iter)->h;
+	segment_length = region().rect.h;
 
-	while(segment_length < height * (*surfaces_iter)->h) {
+	while(segment_length < map_background->h) {
 		dest.y = segment_length;
 
 		segment_length *= 2;
@@ -99,28 +98,32 @@ map::map(SDL_Surface* screen, SDL_Surface* background, surface_cache* cache, tcl
 		SDL_BlitSurface(map_background, NULL, map_background, &dest);
 	}
 
-	SDL_FreeSurface((*surfaces_iter));
-	(*surfaces_iter) = map_background;
+	surface_region background_region = { map_background, map_background->clip_rect };
+	image(background_region);
 
 	scroll = false;
 
 	map_width = (tile_width * width);
 	map_height = (tile_height * height);
 
-	m_x_min = -map_width + screen->w;
-	m_y_min = -map_height + screen->h;
+	bounds(-map_width + screen->w, 0, -map_height + screen->h, 0);
+
+	// Scrolling is decided in calculate(), so the map never sleeps
 
-	m_x_max = 0;
-	m_y_max = 0;
+	state().always_awake[node()] = 1;
+	wake();
 
 	m_player = NULL;
 
 	old_x = x();
 	old_y = y();
+
+	m_view.x(-x());
+	m_view.y(-y());
 }
 
 map::~map() {
-	//dtor
+	SDL_FreeSurface(map_background);
 }
 
 int16_t map::follower_obstructed() {
@@ -151,8 +154,6 @@ void map::calculate() {
 			m_player->animate(false);
 		}
 
-		set_offsets();
-
 		if(!(follower_obstructed() & DIR_N) && !(follower_obstructed() & DIR_S) && old_y != y()) {
 			old_y = y();
 			m_player->animate(true);
@@ -166,6 +167,22 @@ void map::calculate() {
 		old_y = y();
 		old_x = x();
 	}
+
+	// The map sits at the negated camera position
+
+	m_view.x(-x());
+	m_view.y(-y());
+
+	// Keeps the player on screen, it moves through the world with the camera
+
+	if(m_player != NULL)
+		m_player->center();
+}
+
+void map::add_follower(gfx_object* object) {
+	attach(object, NULL, &m_view);
+
+	followers.push_back(object);
 }
 
 void map::display() {
@@ -176,35 +193,39 @@ void map::display() {
 	dest.w = map_background->w;
 	dest.h = map_background->h;
 
-	SDL_BlitSurface(map_background, NULL, m_screen, &dest);
+	// map_background is already tiled one tile past the screen, so it works as a wraparound scroll buffer
 
-	SDL_BlitSurface(m_screen, NULL, m_background, NULL);
+	blitter::copy(map_background, NULL, m_screen, &dest);
+	stats()->blit(dest);
 }
 
 bool map::handle(controller_press_event* event) {
+	node_state& state = this->state();
+	uint32_t node = this->node();
+
 	switch(event->sym()) {
 	case SDLK_UP:
-		if(y() + 1 < m_y_max && !(follower_obstructed() & DIR_N)) {
-			m_speed_y = 1;
-			m_target_y += map_height;
+		if(y() + 1 < state.y_max[node] && !(follower_obstructed() & DIR_N)) {
+			state.speed_y[node] = 1;
+			state.target_y[node] += map_height;
 		}
 		break;
 	case SDLK_DOWN:
-		if(y() - 1 > m_y_min && !(follower_obstructed() & DIR_S)) {
-			m_speed_y = -1;
-			m_target_y -= map_height;
+		if(y() - 1 > state.y_min[node] && !(follower_obstructed() & DIR_S)) {
+			state.speed_y[node] = -1;
+			state.target_y[node] -= map_height;
 		}
 		break;
 	case SDLK_LEFT:
-		if(x() + 1 < m_x_max && !(follower_obstructed() & DIR_W)) {
-			m_speed_x = 1;
-			m_target_x += map_width;
+		if(x() + 1 < state.x_max[node] && !(follower_obstructed() & DIR_W)) {
+			state.speed_x[node] = 1;
+			state.target_x[node] += map_width;
 		}
 		break;
 	case SDLK_RIGHT:
-		if(x() - 1 > m_x_min && !(follower_obstructed() & DIR_E)) {
-			m_speed_x = -1;
-			m_target_x -= map_width;
+		if(x() - 1 > state.x_min[node] && !(follower_obstructed() & DIR_E)) {
+			state.speed_x[node] = -1;
+			state.target_x[node] -= map_width;
 		}
 		break;
 	default:
@@ -225,14 +246,21 @@ bool map::handle(controller_press_event* event) {
 }
 
 bool map::handle(controller_release_event* event) {
+	node_state& state = this->state();
+	uint32_t node = this->node();
+
+	// Keep going if the arrow for the current direction is still held, e.g. the opposite one was let go
+
 	switch(event->sym()) {
 	case SDLK_UP:
 	case SDLK_DOWN:
-		stop_movement_y();
+		if(!(state.speed_y[node] > 0 && input_state::held(SDLK_UP)) && !(state.speed_y[node] < 0 && input_state::held(SDLK_DOWN)))
+			stop_movement_y();
 		break;
 	case SDLK_LEFT:
 	case SDLK_RIGHT:
-		stop_movement_x();
+		if(!(state.speed_x[node] > 0 && input_state::held(SDLK_LEFT)) && !(state.speed_x[node] < 0 && input_state::held(SDLK_RIGHT)))
+			stop_movement_x();
 		break;
 	}
 
@@ -262,4 +290,9 @@ bool map::handle(pointer_move_event* event) {
 
 void map::current_player(player* player) {
 	m_player = player;
+
+	// The player walks in the same space as the followers it is depth sorted against
+
+	attach(player, NULL, &m_view);
+	player->center();
 }
@@ -42,7 +42,9 @@ private:
     SDL_Surface* map_background;
 
     unsigned short tile_width, tile_height;
-    uint16_t map_width, map_height;
+    int32_t map_width, map_height;
+
+    camera m_view;
 
     player* m_player;
 
@@ -50,7 +52,7 @@ private:
 
     bool scroll;
 
-    int16_t old_x, old_y;
+    int32_t old_x, old_y;
 
     tcl_bind* m_bind;
 
@@ -69,6 +71,11 @@ public:
     void display();
     void calculate();
 
+    /**
+     * Followers are placed in world space and viewed through the map's camera.
+     */
+    void add_follower(gfx_object* object);
+
     template<class T>
     void event_to_layer_area(T* event, int16_t x, int16_t y, uint16_t w, uint16_t h) const {
 	for(
@@ -31,11 +31,11 @@
 
 #include "../globals.h"
 #include "../constants.h"
+#include "../inputstate.h"
 
 player::player(SDL_Surface* screen, SDL_Surface* background, surface_cache* cache) : controllable_sprite(screen, background, cache) {
 	active(true);
 	last_dir = DIR_S;
-	keys = 0;
 }
 
 void player::push_file(uint8_t dir, const std::string &file) {
@@ -44,28 +44,36 @@ void player::push_file(uint8_t dir, const std::string &file) {
 	center();
 }
 
+void player::push_files(const file_list& files) {
+	sprite::push_files(files);
+
+	center();
+}
+
+void player::push_sheet(int16_t dir, const std::string &file, uint16_t frame_w, uint16_t frame_h, const std::vector<uint16_t>& cells) {
+	sprite::push_sheet(dir, file, frame_w, frame_h, cells);
+
+	center();
+}
+
 bool player::handle(controller_press_event* event) {
 	switch(event->sym()) {
 	case SDLK_UP:
-		keys++;
 		last_dir = dir();
 		dir(DIR_N);
 		animate(true);
 		break;
 	case SDLK_DOWN:
-		keys++;
 		last_dir = dir();
 		dir(DIR_S);
 		animate(true);
 		break;
 	case SDLK_LEFT:
-		keys++;
 		last_dir = dir();
 		dir(DIR_W);
 		animate(true);
 		break;
 	case SDLK_RIGHT:
-		keys++;
 		last_dir = dir();
 		dir(DIR_E);
 		animate(true);
@@ -75,32 +83,53 @@ bool player::handle(controller_press_event* event) {
 	return PASS;
 }
 
+uint8_t player::held_dir() {
+	static const SDLKey arrows[4] = { SDLK_UP, SDLK_DOWN, SDLK_LEFT, SDLK_RIGHT };
+	static const uint8_t dirs[4] = { DIR_N, DIR_S, DIR_W, DIR_E };
+
+	uint8_t held = DIR_NONE;
+
+	for(uint8_t i = 0; i < 4; i++) {
+		if(input_state::held(arrows[i])) {
+			if(dirs[i] == last_dir)
+				return last_dir;
+
+			if(held == DIR_NONE)
+				held = dirs[i];
+		}
+	}
+
+	return held;
+}
+
 bool player::handle(controller_release_event* event) {
+	uint8_t released;
+
 	switch(event->sym()) {
 	case SDLK_UP:
+		released = DIR_N;
+		break;
 	case SDLK_DOWN:
+		released = DIR_S;
+		break;
 	case SDLK_LEFT:
+		released = DIR_W;
+		break;
 	case SDLK_RIGHT:
-		keys--;
+		released = DIR_E;
 		break;
+	default:
+		return PASS;
 	}
 
-	if(keys > 0) {
-		switch(event->sym()) {
-		case SDLK_UP:
-		case SDLK_DOWN:
-			if(last_dir != DIR_N && last_dir != DIR_S)
-				dir(last_dir);
-			break;
-		case SDLK_LEFT:
-		case SDLK_RIGHT:
-			if(last_dir != DIR_W && last_dir != DIR_E)
-				dir(last_dir);
-			break;
-		}
-	} else {
+	// The input snapshot already saw this release, so it knows what is still held
+
+	uint8_t held = held_dir();
+
+	if(held == DIR_NONE)
 		animate(false);
-	}
+	else if(released == dir())
+		dir(held);
 
 	return PASS;
 }
@@ -36,7 +36,11 @@
 class player : public controllable_sprite {
 private:
     uint8_t last_dir;
-    uint8_t keys;
+
+    /**
+     * Direction of an arrow that is still held, last_dir if it is one of them, DIR_NONE if none is.
+     */
+    uint8_t held_dir();
 protected:
     bool handle(controller_press_event* event);
     bool handle(controller_release_event* event);
@@ -44,6 +48,8 @@ public:
     player(SDL_Surface* screen, SDL_Surface* background, surface_cache* cache);
 
     void push_file(uint8_t dir, const std::string &file);
+    void push_files(const file_list& files);
+    void push_sheet(int16_t dir, const std::string &file, uint16_t frame_w, uint16_t frame_h, const std::vector<uint16_t>& cells);
 };
 
 #endif // PLAYER_H
@@ -0,0 +1,500 @@
+/*
+	Copyright (c) 2010, Markus Wagner (bgld)
+	All rights reserved.
+
+	Redistribution and use in source and binary forms, with or without
+	modification, are permitted provided that the following conditions are
+	met:
+	- Redistributions of source code must retain the above copyright
+	  notice, this list of conditions and the following disclaimer.
+	- Redistributions in binary form must reproduce the above copyright
+	  notice, this list of conditions and the following disclaimer in the
+	  documentation and/or other materials provided with the distribution.
+	- Neither the name "fawesome" or "FawesomeEngine" nor the names of its contributors
+	  may be used to endorse or promote products derived from this software
+	  without specific prior written permission.
+
+	THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+	"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+	LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+	PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL MARKUS WAGNER BE
+	LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+	CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+	SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+	INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+	CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+	ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+	THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "scenegraph.h"
+
+#include <algorithm>
+#include <limits>
+
+void node_state::push() {
+	target_x.push_back(0);
+	target_y.push_back(0);
+	speed_x.push_back(0);
+	speed_y.push_back(0);
+
+	x_min.push_back(0);
+	x_max.push_back(0);
+	y_min.push_back(0);
+	y_max.push_back(0);
+	bounded.push_back(0);
+
+	moved.push_back(0);
+	changed.push_back(0);
+
+	alpha.push_back(0);
+	target_alpha.push_back(0);
+	speed_alpha.push_back(0);
+	alpha_cycle.push_back(0);
+	alpha_min.push_back(0);
+	alpha_max.push_back(0);
+	speed_alpha_cycle.push_back(0);
+
+	angle.push_back(0);
+	target_angle.push_back(0);
+	speed_angle.push_back(0);
+	rotation_cycle.push_back(0);
+	speed_angle_cycle.push_back(0);
+
+	animate.push_back(0);
+	anim_counter.push_back(0);
+	anim_wait.push_back(0);
+	anim_frame.push_back(0);
+	frame_count.push_back(0);
+	timed.push_back(0);
+	clip_start.push_back(0);
+	animated.push_back(0);
+
+	awake.push_back(0);
+	always_awake.push_back(0);
+}
+
+void node_state::reset(uint32_t node) {
+	target_x[node] = 0;
+	target_y[node] = 0;
+	speed_x[node] = 0;
+	speed_y[node] = 0;
+
+	x_min[node] = std::numeric_limits<int32_t>::min();
+	x_max[node] = std::numeric_limits<int32_t>::max();
+	y_min[node] = std::numeric_limits<int32_t>::min();
+	y_max[node] = std::numeric_limits<int32_t>::max();
+	bounded[node] = 1;
+
+	moved[node] = 0;
+	changed[node] = 0;
+
+	alpha[node] = 255;
+	target_alpha[node] = 255;
+	speed_alpha[node] = 0;
+	alpha_cycle[node] = 0;
+	alpha_min[node] = 0;
+	alpha_max[node] = 255;
+	speed_alpha_cycle[node] = 0;
+
+	angle[node] = 0;
+	target_angle[node] = 0;
+	speed_angle[node] = 0;
+	rotation_cycle[node] = 0;
+	speed_angle_cycle[node] = 0;
+
+	animate[node] = 0;
+	anim_counter[node] = 0;
+	anim_wait[node] = 10;
+	anim_frame[node] = 0;
+	frame_count[node] = 0;
+	timed[node] = 0;
+	clip_start[node] = 0;
+	animated[node] = 0;
+
+	awake[node] = 0;
+	always_awake[node] = 0;
+}
+
+static inline int32_t snap(int32_t coord, int32_t target, int32_t speed) {
+	// Lands exactly on the target once it is within one step
+
+	int32_t distance = target - coord;
+
+	return (distance < 0 ? -distance : distance) <= (speed < 0 ? -speed : speed) ? target : coord + speed;
+}
+
+static inline int32_t clamp(int32_t value, int32_t low, int32_t high) {
+	return value < low ? low : (value > high ? high : value);
+}
+
+const uint32_t scene_graph::NO_NODE;
+
+scene_graph::scene_graph() {
+	order_stale = false;
+	m_pending = false;
+
+	m_time = 0;
+}
+
+uint32_t scene_graph::create() {
+	uint32_t node;
+
+	if(!free_nodes.empty()) {
+		node = free_nodes.back();
+		free_nodes.pop_back();
+	} else {
+		node = m_parent.size();
+
+		m_parent.push_back(NO_NODE);
+		m_local_x.push_back(0);
+		m_local_y.push_back(0);
+		m_world_x.push_back(0);
+		m_world_y.push_back(0);
+		m_dirty.push_back(0);
+		m_alive.push_back(0);
+
+		m_state.push();
+	}
+
+	m_state.reset(node);
+
+	m_parent[node] = NO_NODE;
+	m_local_x[node] = 0;
+	m_local_y[node] = 0;
+	m_world_x[node] = 0;
+	m_world_y[node] = 0;
+	m_alive[node] = 1;
+
+	mark(node);
+	wake(node);
+	order_stale = true;
+
+	return node;
+}
+
+void scene_graph::destroy(uint32_t node) {
+	// Only marked here, children are orphaned and the node is freed in the next sort() so tearing down many stays linear
+
+	m_alive[node] = 0;
+	dead_nodes.push_back(node);
+
+	order_stale = true;
+}
+
+void scene_graph::collect() {
+	// Orphans keep their world position as their new local one, the dead parents' positions are still intact here
+
+	for(uint32_t i = 0; i < m_parent.size(); i++) {
+		uint32_t parent = m_parent[i];
+
+		if(m_alive[i] && parent != NO_NODE && !m_alive[parent]) {
+			int32_t x = world_x(i);
+			int32_t y = world_y(i);
+
+			m_local_x[i] = x;
+			m_local_y[i] = y;
+			m_parent[i] = NO_NODE;
+
+			mark(i);
+		}
+	}
+
+	uint32_t kept = 0;
+
+	for(uint32_t i = 0; i < m_awake.size(); i++) {
+		m_awake[kept] = m_awake[i];
+		kept += m_alive[m_awake[i]];
+	}
+
+	m_awake.resize(kept);
+
+	for(
+		std::vector<uint32_t>::iterator iter = dead_nodes.begin();
+		iter != dead_nodes.end();
+		iter++
+	) {
+		m_parent[*iter] = NO_NODE;
+		m_state.reset(*iter);
+		free_nodes.push_back(*iter);
+	}
+
+	dead_nodes.clear();
+}
+
+void scene_graph::mark(uint32_t node) {
+	m_dirty[node] = 1;
+	m_pending = true;
+}
+
+uint32_t scene_graph::parent(uint32_t node) const {
+	return m_parent[node];
+}
+
+void scene_graph::parent(uint32_t node, uint32_t parent) {
+	m_parent[node] = parent;
+
+	mark(node);
+	order_stale = true;
+}
+
+int32_t scene_graph::local_x(uint32_t node) const {
+	return m_local_x[node];
+}
+
+void scene_graph::local_x(uint32_t node, int32_t x) {
+	if(m_local_x[node] != x) {
+		m_local_x[node] = x;
+		mark(node);
+	}
+}
+
+int32_t scene_graph::local_y(uint32_t node) const {
+	return m_local_y[node];
+}
+
+void scene_graph::local_y(uint32_t node, int32_t y) {
+	if(m_local_y[node] != y) {
+		m_local_y[node] = y;
+		mark(node);
+	}
+}
+
+int32_t scene_graph::world_x(uint32_t node) const {
+	if(!m_pending)
+		return m_world_x[node];
+
+	int32_t x = 0;
+
+	for(; node != NO_NODE; node = m_parent[node])
+		x += m_local_x[node];
+
+	return x;
+}
+
+int32_t scene_graph::world_y(uint32_t node) const {
+	if(!m_pending)
+		return m_world_y[node];
+
+	int32_t y = 0;
+
+	for(; node != NO_NODE; node = m_parent[node])
+		y += m_local_y[node];
+
+	return y;
+}
+
+node_state& scene_graph::state() {
+	return m_state;
+}
+
+void scene_graph::wake(uint32_t node) {
+	if(!m_state.awake[node]) {
+		m_state.awake[node] = 1;
+		m_awake.push_back(node);
+	}
+}
+
+uint32_t scene_graph::time() const {
+	return m_time;
+}
+
+void scene_graph::time(uint32_t time) {
+	m_time = time;
+}
+
+const std::vector<uint32_t>& scene_graph::awake() const {
+	return m_awake;
+}
+
+void scene_graph::simulate() {
+	node_state& state = m_state;
+	uint32_t count = m_awake.size();
+	uint8_t any_moved = 0;
+
+	// No branches on the data in here, only selects, so the loops stay flat
+
+	for(uint32_t i = 0; i < count; i++) {
+		uint32_t node = m_awake[i];
+		int32_t x = m_local_x[node];
+		int32_t y = m_local_y[node];
+
+		int32_t new_x = snap(x, state.target_x[node], state.speed_x[node]);
+		int32_t new_y = snap(y, state.target_y[node], state.speed_y[node]);
+
+		uint8_t bounded = state.bounded[node];
+		new_x = bounded ? clamp(new_x, state.x_min[node], state.x_max[node]) : new_x;
+		new_y = bounded ? clamp(new_y, state.y_min[node], state.y_max[node]) : new_y;
+
+		uint8_t moved = (new_x != x) | (new_y != y);
+
+		m_local_x[node] = new_x;
+		m_local_y[node] = new_y;
+
+		state.moved[node] |= moved;
+		state.changed[node] = moved;
+		m_dirty[node] |= moved;
+		any_moved |= moved;
+	}
+
+	for(uint32_t i = 0; i < count; i++) {
+		uint32_t node = m_awake[i];
+		int32_t alpha = state.alpha[node];
+
+		int32_t faded = clamp(snap(alpha, state.target_alpha[node], state.speed_alpha[node]), 0, 255);
+
+		// Cycling bounces between the limits
+
+		int32_t low = state.alpha_min[node];
+		int32_t high = state.alpha_max[node];
+		int32_t speed = state.speed_alpha_cycle[node];
+		int32_t probe = alpha + speed;
+
+		speed = (probe <= low) | (probe >= high) ? -speed : speed;
+
+		int32_t cycled = clamp(alpha + speed, low, high);
+
+		uint8_t cycle = state.alpha_cycle[node];
+		int32_t result = cycle ? cycled : faded;
+
+		state.speed_alpha_cycle[node] = cycle ? speed : state.speed_alpha_cycle[node];
+		state.alpha[node] = result;
+		state.changed[node] |= (result != alpha);
+	}
+
+	for(uint32_t i = 0; i < count; i++) {
+		uint32_t node = m_awake[i];
+		int32_t angle = state.angle[node];
+		int32_t target = state.rotation_cycle[node] ? angle + state.speed_angle_cycle[node] : state.target_angle[node];
+
+		int32_t result = snap(angle, target, state.speed_angle[node]);
+
+		// Wrap both so the distance to the target survives
+
+		int32_t wrap = result / 360 * 360;
+
+		state.angle[node] = result - wrap;
+		state.target_angle[node] = target - wrap;
+		state.changed[node] |= (result - wrap != angle);
+	}
+
+	for(uint32_t i = 0; i < count; i++) {
+		uint32_t node = m_awake[i];
+		uint8_t timed = state.timed[node];
+		uint8_t animate = state.animate[node] & !timed;
+		uint16_t counter = state.anim_counter[node];
+		uint16_t wait = state.anim_wait[node] | (state.anim_wait[node] == 0);
+		uint16_t frame = state.anim_frame[node];
+
+		uint8_t advance = animate & (counter % wait == 0);
+		uint16_t next = frame + 1 < state.frame_count[node] ? frame + 1 : 0;
+
+		uint16_t result = timed ? frame : (animate ? (advance ? next : frame) : 0);
+
+		state.anim_frame[node] = result;
+		state.anim_counter[node] = animate ? (advance ? 1 : counter + 1) : counter;
+		state.changed[node] |= (result != frame);
+		state.animated[node] = state.animate[node];
+	}
+
+	m_pending |= any_moved;
+
+	// Whatever has no motion, fade, cycle or animation going and didn't change goes to sleep
+
+	uint32_t kept = 0;
+
+	for(uint32_t i = 0; i < count; i++) {
+		uint32_t node = m_awake[i];
+
+		uint8_t busy = (
+			state.changed[node] | state.moved[node] |
+			state.alpha_cycle[node] | state.rotation_cycle[node] | (state.animate[node] & !state.timed[node]) |
+			state.always_awake[node]
+		) & m_alive[node]; // Destroyed ones drop out here already, before anyone calculates them
+
+		m_awake[kept] = node;
+		kept += busy;
+		state.awake[node] = busy;
+	}
+
+	m_awake.resize(kept);
+}
+
+void scene_graph::sort() {
+	if(!dead_nodes.empty())
+		collect();
+
+	// Bucket the live nodes by depth, parents always end up before their children
+
+	std::vector<uint16_t> depth(m_parent.size(), 0);
+	uint16_t max_depth = 0;
+
+	for(uint32_t i = 0; i < m_parent.size(); i++) {
+		if(!m_alive[i])
+			continue;
+
+		for(uint32_t node = m_parent[i]; node != NO_NODE; node = m_parent[node])
+			depth[i]++;
+
+		max_depth = std::max(max_depth, depth[i]);
+	}
+
+	order.clear();
+
+	for(uint16_t level = 0; level <= max_depth; level++) {
+		for(uint32_t i = 0; i < m_parent.size(); i++) {
+			if(m_alive[i] && depth[i] == level)
+				order.push_back(i);
+		}
+	}
+
+	order_stale = false;
+}
+
+void scene_graph::update() {
+	if(order_stale)
+		sort();
+
+	m_moved.clear();
+
+	if(!m_pending)
+		return;
+
+	for(
+		std::vector<uint32_t>::iterator iter = order.begin();
+		iter != order.end();
+		iter++
+	) {
+		uint32_t node = *iter;
+		uint32_t parent = m_parent[node];
+
+		if(parent == NO_NODE) {
+			if(m_dirty[node]) {
+				m_world_x[node] = m_local_x[node];
+				m_world_y[node] = m_local_y[node];
+
+				m_state.moved[node] = 1;
+				m_moved.push_back(node);
+			}
+		} else if(m_dirty[node] || m_dirty[parent]) {
+			m_world_x[node] = m_local_x[node] + m_world_x[parent];
+			m_world_y[node] = m_local_y[node] + m_world_y[parent];
+
+			m_dirty[node] = 1; // Pass it on to the children
+
+			m_state.moved[node] = 1; // Children of a moving parent need re-sorting too
+			m_moved.push_back(node);
+		}
+	}
+
+	std::fill(m_dirty.begin(), m_dirty.end(), 0);
+	m_pending = false;
+}
+
+const std::vector<uint32_t>& scene_graph::moved() const {
+	return m_moved;
+}
+
+uint32_t scene_graph::count() const {
+	return m_parent.size() - free_nodes.size() - dead_nodes.size();
+}
@@ -0,0 +1,168 @@
+/*
+        Copyright (c) 2010, Markus Wagner (bgld)
+        All rights reserved.
+
+        Redistribution and use in source and binary forms, with or without
+        modification, are permitted provided that the following conditions are
+        met:
+        - Redistributions of source code must retain the above copyright
+          notice, this list of conditions and the following disclaimer.
+        - Redistributions in binary form must reproduce the above copyright
+          notice, this list of conditions and the following disclaimer in the
+          documentation and/or other materials provided with the distribution.
+        - Neither the name "fawesome" or "FawesomeEngine" nor the names of its contributors
+          may be used to endorse or promote products derived from this software
+          without specific prior written permission.
+
+        THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+        "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+        LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+        PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL MARKUS WAGNER BE
+        LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+        CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+        SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+        INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+        CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+        ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+        THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef SCENEGRAPH_H
+#define SCENEGRAPH_H
+
+#include <vector>
+#include <stdint.h>
+
+
+/**
+ * Hot per-frame state of all objects, one packed array per field indexed by node id.
+ * Objects only keep their node id and read and write through here.
+ */
+struct node_state {
+    std::vector<int32_t> target_x, target_y;
+    std::vector<int16_t> speed_x, speed_y;
+
+    std::vector<int32_t> x_min, x_max, y_min, y_max;
+    std::vector<uint8_t> bounded;
+
+    std::vector<uint8_t> moved;
+    std::vector<uint8_t> changed;
+
+    std::vector<uint8_t> alpha, target_alpha;
+    std::vector<int16_t> speed_alpha;
+    std::vector<uint8_t> alpha_cycle, alpha_min, alpha_max;
+    std::vector<int16_t> speed_alpha_cycle;
+
+    std::vector<int16_t> angle, target_angle, speed_angle;
+    std::vector<uint8_t> rotation_cycle;
+    std::vector<int16_t> speed_angle_cycle;
+
+    std::vector<uint8_t> animate;
+    std::vector<uint16_t> anim_counter, anim_wait;
+    std::vector<uint16_t> anim_frame, frame_count;
+    std::vector<uint8_t> timed; // Frame comes from the clip durations at display time, not from simulate()
+    std::vector<uint32_t> clip_start;
+    std::vector<uint8_t> animated; // animate as of the last simulate(), timed clips only restart if it was off
+
+    std::vector<uint8_t> awake, always_awake;
+
+    void push();
+    void reset(uint32_t node);
+};
+
+/**
+ * Flat transform hierarchy for all gfx_objects, indexed by node id.
+ * World positions are resolved in one linear pass over the nodes ordered by depth, parents first.
+ * Nodes whose local position and parent didn't change are skipped.
+ */
+class scene_graph {
+private:
+    std::vector<uint32_t> m_parent;
+    std::vector<int32_t> m_local_x, m_local_y;
+    std::vector<int32_t> m_world_x, m_world_y;
+    std::vector<uint8_t> m_dirty;
+    std::vector<uint8_t> m_alive;
+
+    std::vector<uint32_t> free_nodes;
+    std::vector<uint32_t> dead_nodes; // Destroyed since the last sort(), not yet reusable
+
+    node_state m_state;
+
+    std::vector<uint32_t> m_awake;
+    std::vector<uint32_t> m_moved;
+
+    std::vector<uint32_t> order;
+    bool order_stale;
+
+    bool m_pending;
+
+    uint32_t m_time;
+
+    void mark(uint32_t node);
+
+    /**
+     * Orphans the children of destroyed nodes and frees those, one pass for everything destroyed since the last sort().
+     */
+    void collect();
+    void sort();
+public:
+    static const uint32_t NO_NODE = 0xffffffff;
+
+    scene_graph();
+
+    uint32_t create();
+    void destroy(uint32_t node);
+
+    uint32_t parent(uint32_t node) const;
+    void parent(uint32_t node, uint32_t parent);
+
+    int32_t local_x(uint32_t node) const;
+    void local_x(uint32_t node, int32_t x);
+    int32_t local_y(uint32_t node) const;
+    void local_y(uint32_t node, int32_t y);
+
+    /**
+     * World position, from the last update or walked up the parents if something changed since then.
+     */
+    int32_t world_x(uint32_t node) const;
+    int32_t world_y(uint32_t node) const;
+
+    node_state& state();
+
+    /**
+     * The clock timed animations run on, in milliseconds, the same for everything during a frame.
+     */
+    uint32_t time() const;
+    void time(uint32_t time);
+
+    /**
+     * Puts a node back on the awake list, needed after anything that starts motion, fading, rotation or animation.
+     */
+    void wake(uint32_t node);
+
+    /**
+     * The nodes simulate() steps, in no particular order. It may grow while being iterated.
+     */
+    const std::vector<uint32_t>& awake() const;
+
+    /**
+     * Advances position, alpha, angle and animation frame of all awake objects, one flat pass per field.
+     * node_state::changed tells which objects actually changed.
+     * Objects with nothing left to do afterwards fall asleep until the next wake().
+     */
+    void simulate();
+
+    /**
+     * Resolves world positions, every node that got a new one is flagged in node_state::moved and listed in moved().
+     */
+    void update();
+
+    /**
+     * The nodes whose world position the last update() recomputed, children of moved parents included.
+     */
+    const std::vector<uint32_t>& moved() const;
+
+    uint32_t count() const;
+};
+
+#endif // SCENEGRAPH_H
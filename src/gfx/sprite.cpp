@@ -32,6 +32,7 @@
 #include <iostream>
 #include <stdexcept>
 #include <sstream>
+#include <limits>
 #include <SDL/SDL_image.h>
 #include <SDL/SDL_rotozoom.h>
 
@@ -41,6 +42,15 @@
 #include "../filenotfoundexception.h"
 #include "player.h"
 #include "../file.h"
+#include "../blitter.h"
+#include "../profiler.h"
+
+static frame_counters discarded; // Until the screen hands out its own
+
+frame_counters* sprite::counters = &discarded;
+animation_registry* sprite::templates = NULL;
+
+static const std::vector<surface_region> no_frames;
 
 void sprite::init(SDL_Surface* screen, SDL_Surface* background, surface_cache* cache) {
 	m_screen = screen;
@@ -50,23 +60,15 @@ void sprite::init(SDL_Surface* screen, SDL_Surface* background, surface_cache* c
 
 	m_obstruct = false;
 
+	m_animation = NULL;
 	m_dir = DIR_NONE;
-	m_animate = false;
-	m_anim_counter = 0;
-	m_anim_wait = 10;
 
-	speed_alpha = 0;
-	speed_alpha_cycle = 0;
-	speed_rotation = 0;
-	speed_rotation_cycle = 0;
+	m_depth_layer = 0;
+	m_depth = 0;
 
-	current_alpha = SDL_ALPHA_OPAQUE;
-	target_alpha = SDL_ALPHA_OPAQUE;
-	m_alpha_cycle = false;
+	frames = &no_frames;
 
-	m_angle = 0;
-	m_target_angle = 0;
-	m_rotation_cycle = false;
+	// Animation, alpha, angle and movement defaults come from node_state::reset
 
 	m_font = NULL;
 	m_text_color.r = FG_COLOR_R;
@@ -78,12 +80,16 @@ void sprite::init(SDL_Surface* screen, SDL_Surface* background, surface_cache* c
 
 	text_surface_update = true;
 
+	m_wrap_width = -1;
+
+	rotated = NULL;
+	rotated_angle = 0;
+
 	m_obs_offset_top = 0;
 	m_obs_offset_right = 0;
 	m_obs_offset_bottom = 0;
 	m_obs_offset_left = 0;
 
-	surfaces_iter = surfaces[0].end();
 }
 
 sprite::sprite(SDL_Surface* screen, SDL_Surface* background, surface_cache* cache, const std::string &file) : gfx_object() {
@@ -94,24 +100,30 @@ sprite::sprite(SDL_Surface* screen, SDL_Surface* background, surface_cache* cach
 
 sprite::sprite(SDL_Surface* screen, SDL_Surface* background, surface_cache* cache) : gfx_object() {
 	init(screen, background, cache);
-
-	surfaces_iter = surfaces[m_dir].end();
 }
 
-sprite::~sprite() { }
+sprite::~sprite() {
+	templates->release(m_animation);
+
+	SDL_FreeSurface(rotated);
+}
 
 void sprite::serialize(std::ostream& stream) {
 	stream.write((char*)&m_obstruct, sizeof(m_obstruct));
 
+	static const file_map no_files;
+
+	const file_map& files = m_animation != NULL ? m_animation->files() : no_files;
+
 	for(
-		std::map<int, std::vector<std::string> >::iterator iter = files.begin();
+		file_map::const_iterator iter = files.begin();
 		iter != files.end();
 		iter++
 	) {
 		stream.write((char*)&iter->first, sizeof(iter->first));
 
 		for(
-			std::vector<std::string>::iterator jter = iter->second.begin();
+			std::vector<std::string>::const_iterator jter = iter->second.begin();
 			jter != iter->second.end();
 			jter++
 		) {
@@ -121,23 +133,26 @@ void sprite::serialize(std::ostream& stream) {
 		stream << (char)0;
 	}
 
+	node_state& state = this->state();
+	uint32_t node = this->node();
+
 	stream.write((char*)&m_dir, sizeof(m_dir));
-	stream.write((char*)&m_animate, sizeof(m_animate));
-	stream.write((char*)&m_anim_counter, sizeof(m_anim_counter));
-	stream.write((char*)&m_anim_wait, sizeof(m_anim_wait));
+	stream.write((char*)&state.animate[node], sizeof(state.animate[node]));
+	stream.write((char*)&state.anim_counter[node], sizeof(state.anim_counter[node]));
+	stream.write((char*)&state.anim_wait[node], sizeof(state.anim_wait[node]));
 
-	stream.write((char*)&speed_alpha, sizeof(speed_alpha));
-	stream.write((char*)&speed_alpha_cycle, sizeof(speed_alpha_cycle));
-	stream.write((char*)&speed_rotation_cycle, sizeof(speed_rotation_cycle));
-	stream.write((char*)&speed_rotation_cycle, sizeof(speed_rotation_cycle));
+	stream.write((char*)&state.speed_alpha[node], sizeof(state.speed_alpha[node]));
+	stream.write((char*)&state.speed_alpha_cycle[node], sizeof(state.speed_alpha_cycle[node]));
+	stream.write((char*)&state.speed_angle_cycle[node], sizeof(state.speed_angle_cycle[node]));
+	stream.write((char*)&state.speed_angle_cycle[node], sizeof(state.speed_angle_cycle[node]));
 
-	stream.write((char*)&current_alpha, sizeof(current_alpha));
-	stream.write((char*)&target_alpha, sizeof(target_alpha));
-	stream.write((char*)&m_alpha_cycle, sizeof(m_alpha_cycle));
+	stream.write((char*)&state.alpha[node], sizeof(state.alpha[node]));
+	stream.write((char*)&state.target_alpha[node], sizeof(state.target_alpha[node]));
+	stream.write((char*)&state.alpha_cycle[node], sizeof(state.alpha_cycle[node]));
 
-	stream.write((char*)&m_angle, sizeof(m_angle));
-	stream.write((char*)&m_target_angle, sizeof(m_target_angle));
-	stream.write((char*)&m_rotation_cycle, sizeof(m_rotation_cycle));
+	stream.write((char*)&state.angle[node], sizeof(state.angle[node]));
+	stream.write((char*)&state.target_angle[node], sizeof(state.target_angle[node]));
+	stream.write((char*)&state.rotation_cycle[node], sizeof(state.rotation_cycle[node]));
 
 	stream.write((char*)&m_text_color, sizeof(m_text_color));
 
@@ -151,11 +166,11 @@ void sprite::serialize(std::ostream& stream) {
 	stream.write((char*)&m_obs_offset_bottom, sizeof(m_obs_offset_bottom));
 	stream.write((char*)&m_obs_offset_left, sizeof(m_obs_offset_left));
 
-	stream.write((char*)&m_x, sizeof(m_x));
-	stream.write((char*)&m_y, sizeof(m_y));
+	int32_t local_x = x();
+	int32_t local_y = y();
 
-	stream.write((char*)&m_offset_x, sizeof(m_offset_x));
-	stream.write((char*)&m_offset_y, sizeof(m_offset_y));
+	stream.write((char*)&local_x, sizeof(local_x));
+	stream.write((char*)&local_y, sizeof(local_y));
 }
 
 void sprite::deserialize(std::istream& stream) {
@@ -163,27 +178,60 @@ void sprite::deserialize(std::istream& stream) {
 }
 
 void sprite::push_file(int16_t dir, const std::string &file) {
-	SDL_Surface* image_surface = m_cache->fetch(file);
+	m_animation = templates->extend(m_animation, dir, file);
 
-	files[dir].push_back(file);
-	surfaces[dir].push_back(image_surface);
+	this->dir(dir);
 
-	surfaces_iter = surfaces[dir].begin();
-	m_dir = dir;
+	bounds(-region().rect.w, m_screen->w, -region().rect.h, m_screen->h);
+}
+
+void sprite::push_files(const file_list& files) {
+	if(files.empty())
+		return;
+
+	m_animation = templates->extend(m_animation, files);
+
+	this->dir(files.back().first);
+
+	bounds(-region().rect.w, m_screen->w, -region().rect.h, m_screen->h);
+}
+
+void sprite::push_sheet(int16_t dir, const std::string &file, uint16_t frame_w, uint16_t frame_h, const std::vector<uint16_t>& cells) {
+	m_animation = templates->extend(m_animation, dir, file, frame_w, frame_h, cells);
 
-	m_x_min = -(*surfaces_iter)->w;
-	m_x_max = m_screen->w;
+	this->dir(dir);
 
-	m_y_min = -(*surfaces_iter)->h;
-	m_y_max = m_screen->h;
+	bounds(-region().rect.w, m_screen->w, -region().rect.h, m_screen->h);
 }
 
 void sprite::push_file(const std::string &file) {
 	push_file(DIR_NONE, file);
 }
 
+SDL_Surface* sprite::view(const surface_region& region) {
+	SDL_Surface* surface = region.surface;
+
+	if(region.rect.x == 0 && region.rect.y == 0 && region.rect.w == surface->w && region.rect.h == surface->h)
+		return surface;
+
+	// Points into the pixels of the shared surface, nothing gets copied
+
+	return SDL_CreateRGBSurfaceFrom(
+		(uint8_t*)surface->pixels + region.rect.y * surface->pitch + region.rect.x * surface->format->BytesPerPixel,
+		region.rect.w,
+		region.rect.h,
+		surface->format->BitsPerPixel,
+		surface->pitch,
+
+		surface->format->Rmask,
+		surface->format->Gmask,
+		surface->format->Bmask,
+		surface->format->Amask
+	);
+}
+
 bool sprite::has_alpha() {
-	return(config->bool_value("surface_alpha") && current_alpha != SDL_ALPHA_OPAQUE);
+	return(config->bool_value("surface_alpha") && alpha() != SDL_ALPHA_OPAQUE);
 }
 
 void sprite::obstruct(bool obstruct, int16_t offset_top, int16_t offset_right, int16_t offset_bottom, int16_t offset_left) {
@@ -198,6 +246,8 @@ void sprite::obstruct(bool obstruct, int16_t offset_top, int16_t offset_right, i
 uint16_t sprite::obstructed(player* player) const {
 	int16_t ret = DIR_NONE;
 
+	counters->obstruction_tests++;
+
 	int32_t disp_x = display_x();
 	int32_t disp_y = display_y();
 
@@ -262,130 +312,137 @@ uint16_t sprite::obstructed(player* player) const {
 void sprite::calculate() {
 	gfx_object::calculate();
 
-	if(m_animate) {
-		// Cycle through surfaces if counter reached or has been restarted
-
-		if(m_anim_counter % m_anim_wait == 0) {
-			surfaces_iter++;
-
-			if(surfaces_iter == surfaces[m_dir].end())
-				surfaces_iter = surfaces[m_dir].begin();
-
-			m_anim_counter = 0;
-		}
-
-		m_anim_counter++;
-	} else {
-		surfaces_iter = surfaces[m_dir].begin();
-	}
+	// Animation frames, alpha and angle are stepped in scene_graph::simulate
 }
 
 void sprite::display() {
-	if(current_alpha != target_alpha) {
-		if(
-			(
-			target_alpha <= current_alpha + speed_alpha ||
-			target_alpha >= current_alpha - speed_alpha
-			) &&
-			current_alpha + speed_alpha >= 0 &&
-			current_alpha + speed_alpha < 255
-			) {
-			alpha(current_alpha + speed_alpha);
-		} else {
-			alpha(target_alpha);
-		}
-	}
-
-	if(m_rotation_cycle) {
-		m_target_angle = m_angle + speed_rotation_cycle;
-	}
-
-	if(m_angle != m_target_angle) {
-		m_angle += speed_rotation;
-		m_angle %= 360;
-	}
-
-	display(m_x, m_y);
+	display(x(), y());
 }
 
-void sprite::display(int16_t x, int16_t y) {
-	if(m_alpha_cycle) {
-		int16_t cycle_alpha;
-
-		if(current_alpha + speed_alpha_cycle <= m_alpha_min || current_alpha + speed_alpha_cycle >= m_alpha_max) {
-			speed_alpha_cycle = -speed_alpha_cycle;
-		}
-
-		cycle_alpha = current_alpha + speed_alpha_cycle;
-
-		if(cycle_alpha < m_alpha_min) {
-			cycle_alpha = m_alpha_min;
-		} else if(cycle_alpha > m_alpha_max) {
-			cycle_alpha = m_alpha_max;
-		}
-
-		alpha(cycle_alpha);
-	}
-
-	display(x, y, current_alpha);
+void sprite::display(int32_t x, int32_t y) {
+	display(x, y, alpha());
 }
 
-void sprite::display(int16_t x, int16_t y, uint8_t alpha) {
-	if(!surfaces[m_dir].empty() && alpha != SDL_ALPHA_TRANSPARENT) {
+void sprite::display(int32_t x, int32_t y, uint8_t alpha) {
+	if(has_region() && alpha != SDL_ALPHA_TRANSPARENT) {
 #ifdef DEBUG
 		std::stringstream text_stream;
-		text_stream << "x: " << m_x << "; y: " << m_x << std::endl;
-		text_stream << "offset_x: " << m_offset_x << "; offset_y: " << m_offset_y << std::endl;
+		text_stream << "x: " << this->x() << "; y: " << this->y() << std::endl;
+		text_stream << "world_x: " << world_x() << "; world_y: " << world_y() << std::endl;
 		text_stream << "display_x: " << display_x() << "; display_y: " << display_y() << std::endl;
 		text_stream << "layer_ID: " << layer_id() << std::endl;
 		text(text_stream.str());
 #endif
 
-		SDL_Surface* last_surface = (*surfaces_iter);
-		SDL_Rect dest_rect = {display_x(), display_y(), (*surfaces_iter)->w, (*surfaces_iter)->h};
+		surface_region last_region = region();
 
 		this->x(x);
 		this->y(y);
 		this->alpha(alpha);
 
+		// Cull while still in 32 bit, leaving room for rotation, SDL_Rect only holds 16 bit
+
+		int32_t disp_x = display_x();
+		int32_t disp_y = display_y();
+		int32_t reach = last_region.rect.w + last_region.rect.h;
+
+		if(disp_x + reach < 0 || disp_y + reach < 0 || disp_x - reach >= m_screen->w || disp_y - reach >= m_screen->h) {
+			counters->culled++;
+			return;
+		}
+
+		// Timed animations only get their frame here, when they can actually be seen
+
+		node_state& state = this->state();
+		uint32_t node = this->node();
+
+		if(state.timed[node] && state.animate[node]) {
+			state.anim_frame[node] = m_animation->frame_at(m_dir, graph()->time() - state.clip_start[node]);
+			last_region = region();
+		}
+
+		SDL_Rect source_rect = last_region.rect;
+		SDL_Rect dest_rect = {(Sint16)disp_x, (Sint16)disp_y, last_region.rect.w, last_region.rect.h}; // Culled above, so it fits
+
 		// Rotozoom stuff
 
 		SDL_Surface* rotozoomed_surface;
 
-		if(m_angle != 0) {
-			rotozoomed_surface = rotozoomSurface(last_surface, m_angle, 1, INTERPOLATE_ROTOZOOM);
+		int16_t angle = this->angle();
+
+		if(angle != 0) {
+			bool stale =
+				rotated == NULL ||
+				rotated_angle != angle ||
+				rotated_region.surface != last_region.surface ||
+				rotated_region.rect.x != last_region.rect.x ||
+				rotated_region.rect.y != last_region.rect.y ||
+				rotated_region.rect.w != last_region.rect.w ||
+				rotated_region.rect.h != last_region.rect.h;
+
+			if(stale) {
+				SDL_Surface* region_view = view(last_region);
+
+				if(rotated != NULL)
+					counters->surfaces_freed++;
+
+				SDL_FreeSurface(rotated);
+				rotated = rotozoomSurface(region_view, angle, 1, INTERPOLATE_ROTOZOOM);
+				rotated_region = last_region;
+				rotated_angle = angle;
+
+				counters->surfaces_created++;
+
+				if(region_view != last_region.surface) {
+					SDL_FreeSurface(region_view);
+
+					counters->surfaces_created++;
+					counters->surfaces_freed++;
+				}
+			}
+
+			rotozoomed_surface = rotated;
+			source_rect = rotozoomed_surface->clip_rect;
 		} else {
-			rotozoomed_surface = last_surface;
+			rotozoomed_surface = last_region.surface;
 		}
 
-		dest_rect.x += ((last_surface->w - rotozoomed_surface->w) / 2);
-		dest_rect.y += ((last_surface->h - rotozoomed_surface->h) / 2);
+		dest_rect.x += ((last_region.rect.w - source_rect.w) / 2);
+		dest_rect.y += ((last_region.rect.h - source_rect.h) / 2);
 
 		// Blitting
 
 		if(
-			dest_rect.x > -rotozoomed_surface->w &&
-			dest_rect.y > -rotozoomed_surface->h &&
+			dest_rect.x > -source_rect.w &&
+			dest_rect.y > -source_rect.h &&
 			dest_rect.x < m_screen->w &&
 			dest_rect.y < m_screen->h
 			) {
-			if(has_alpha())
-				SDL_BlitSurface(m_screen, NULL, m_background, NULL);
+			if(has_alpha()) {
+				// Only the covered area is needed for blending back
+
+				SDL_Rect background_rect = {dest_rect.x, dest_rect.y, source_rect.w, source_rect.h};
+				blitter::copy(m_screen, &background_rect, m_background, &background_rect);
+				counters->blit(background_rect);
+			}
 
-			if(SDL_BlitSurface(rotozoomed_surface, NULL, m_screen, &dest_rect) < 0) {
+			if(SDL_BlitSurface(rotozoomed_surface, &source_rect, m_screen, &dest_rect) < 0) {
 				throw std::runtime_error("Couldn't blit rotozoomed_surface");
 			}
-		}
 
-		if(m_angle != 0)
-			SDL_FreeSurface(rotozoomed_surface);
+			counters->blit(dest_rect);
+		} else {
+			counters->culled++;
+		}
 
 		// Loop through text lines and add them on top
 
 		if(!text_lines.empty()) {
+			profile_scope scope(profiler::PHASE_TEXT);
+
 			SDL_Rect font_rect = dest_rect;
-			font_rect.x = display_x() + m_text_offset_x;
-			font_rect.y = display_y() + m_text_offset_y;
+			font_rect.x = disp_x + m_text_offset_x;
+			font_rect.y = disp_y + m_text_offset_y;
 			SDL_Rect temp_rect = font_rect;
 
 			int16_t line_skip = config->int_value("font_skip");
@@ -401,11 +458,17 @@ void sprite::display(int16_t x, int16_t y, uint8_t alpha) {
 				font_rect.y += line_skip;
 
 				if((*iter).second == NULL || text_surface_update) { // If line surface doesn't exist yet/is stale
+					if((*iter).second != NULL)
+						counters->surfaces_freed++;
+
 					SDL_FreeSurface((*iter).second);
 					(*iter).second = TTF_RenderUTF8_Blended(m_font, (*iter).first.c_str(), m_text_color);
+
+					counters->surfaces_created++;
 				}
 
 				SDL_BlitSurface((*iter).second, NULL, m_screen, &temp_rect);
+				counters->blit(temp_rect);
 				temp_rect = font_rect;
 			}
 
@@ -414,15 +477,26 @@ void sprite::display(int16_t x, int16_t y, uint8_t alpha) {
 
 		// Apply alpha by overlaying the surface with its background (SDL doesn't support anything else)
 
-		if(has_alpha()) {
-			SDL_Surface* alpha_bg = SDL_DisplayFormat(m_background);
-			SDL_SetAlpha(alpha_bg, SDL_SRCALPHA | SDL_RLEACCEL, SDL_ALPHA_OPAQUE - current_alpha);
+		if(has_alpha() && dest_rect.w > 0 && dest_rect.h > 0) {
+			// Only the covered area goes through a pooled scratch surface, not a copy of the whole background
+
+			SDL_Surface* alpha_bg = blitter::scratch(dest_rect.w, dest_rect.h, m_background->format);
+			SDL_SetAlpha(alpha_bg, SDL_SRCALPHA, SDL_ALPHA_OPAQUE - this->alpha());
+
+			SDL_Rect scratch_rect = {0, 0, dest_rect.w, dest_rect.h};
 
-			SDL_BlitSurface(m_background, &dest_rect, alpha_bg, &dest_rect);
-			SDL_BlitSurface(alpha_bg, &dest_rect, m_screen, &dest_rect);
+			SDL_BlitSurface(m_background, &dest_rect, alpha_bg, &scratch_rect);
+			counters->blit(scratch_rect);
 
-			SDL_FreeSurface(alpha_bg);
-			alpha_bg = NULL;
+			scratch_rect.x = 0;
+			scratch_rect.y = 0;
+			scratch_rect.w = dest_rect.w;
+			scratch_rect.h = dest_rect.h;
+
+			SDL_BlitSurface(alpha_bg, &scratch_rect, m_screen, &dest_rect);
+			counters->blit(dest_rect);
+
+			blitter::release(alpha_bg);
 		}
 
 		prev_rect = dest_rect;
@@ -430,15 +504,13 @@ void sprite::display(int16_t x, int16_t y, uint8_t alpha) {
 }
 
 void sprite::stop_movement_x() {
-	m_speed_x = 0;
-
-	m_target_x = m_x;
+	state().speed_x[node()] = 0;
+	state().target_x[node()] = x();
 }
 
 void sprite::stop_movement_y() {
-	m_speed_y = 0;
-
-	m_target_y = m_y;
+	state().speed_y[node()] = 0;
+	state().target_y[node()] = y();
 }
 
 void sprite::stop_movement() {
@@ -446,98 +518,115 @@ void sprite::stop_movement() {
 	stop_movement_y();
 }
 
-void sprite::move(int16_t x, int16_t y, uint16_t speed) {
-	m_target_x = x;
-	m_target_y = y;
+void sprite::move(int32_t x, int32_t y, uint16_t speed) {
+	node_state& state = this->state();
+	uint32_t node = this->node();
 
-	if(x > m_x) {
-		m_speed_x = speed;
-	} else if(x < m_x) {
-		m_speed_x = -speed;
+	state.target_x[node] = x;
+	state.target_y[node] = y;
+
+	if(x > this->x()) {
+		state.speed_x[node] = speed;
+	} else if(x < this->x()) {
+		state.speed_x[node] = -speed;
 	} else {
-		m_speed_x = 0;
+		state.speed_x[node] = 0;
 	}
 
-	if(y > m_y) {
-		m_speed_y = speed;
-	} else if(y < m_y) {
-		m_speed_y = -speed;
+	if(y > this->y()) {
+		state.speed_y[node] = speed;
+	} else if(y < this->y()) {
+		state.speed_y[node] = -speed;
 	} else {
-		m_speed_y = 0;
+		state.speed_y[node] = 0;
 	}
+
+	wake();
 }
 
-void sprite::move_relative(int16_t x, int16_t y, uint16_t speed) {
-	move(m_x + x, m_y + y, speed);
+void sprite::move_relative(int32_t x, int32_t y, uint16_t speed) {
+	move(this->x() + x, this->y() + y, speed);
 }
 
 void sprite::stop_alpha() {
-	speed_alpha = 0;
-
-	target_alpha = current_alpha;
+	state().speed_alpha[node()] = 0;
+	state().target_alpha[node()] = alpha();
 }
 
 void sprite::alpha_to(uint8_t alpha, uint16_t speed) {
 	stop_alpha_cycle();
 
-	target_alpha = alpha;
+	node_state& state = this->state();
+	uint32_t node = this->node();
+
+	state.target_alpha[node] = alpha;
 
-	if(alpha > current_alpha) {
-		speed_alpha = speed;
-	} else if(alpha < current_alpha) {
-		speed_alpha = -speed;
+	if(alpha > state.alpha[node]) {
+		state.speed_alpha[node] = speed;
+	} else if(alpha < state.alpha[node]) {
+		state.speed_alpha[node] = -speed;
 	} else {
-		speed_alpha = 0;
+		state.speed_alpha[node] = 0;
 	}
+
+	wake();
 }
 
 void sprite::alpha_to_relative(uint8_t alpha, uint16_t speed) {
-	alpha_to(current_alpha + alpha, speed);
+	alpha_to(this->alpha() + alpha, speed);
 }
 
 void sprite::stop_alpha_cycle() {
-	m_alpha_cycle = false;
+	state().alpha_cycle[node()] = false;
 }
 
 void sprite::alpha_cycle(uint8_t alpha_start, uint8_t alpha_end, uint16_t speed) {
 	stop_alpha();
 
-	m_alpha_min = std::min(alpha_start, alpha_end);
-	m_alpha_max = std::max(alpha_start, alpha_end);
+	node_state& state = this->state();
+	uint32_t node = this->node();
+
+	state.alpha_min[node] = std::min(alpha_start, alpha_end);
+	state.alpha_max[node] = std::max(alpha_start, alpha_end);
 
-	speed_alpha_cycle = speed;
+	state.speed_alpha_cycle[node] = speed;
 
-	m_alpha_cycle = true;
+	state.alpha_cycle[node] = true;
+
+	wake();
 }
 
 void sprite::rotate(int16_t angle, int16_t speed) {
 	stop_rotation_cycle();
 
-	m_target_angle = angle;
-	speed_rotation = speed;
+	state().target_angle[node()] = angle;
+	state().speed_angle[node()] = speed;
+
+	wake();
 }
 
 void sprite::rotate_relative(int16_t angle, int16_t speed) {
-	rotate(m_angle + angle, speed);
+	rotate(this->angle() + angle, speed);
 }
 
 void sprite::stop_rotation() {
-	speed_rotation = 0;
-
-	m_target_angle = m_angle;
+	state().speed_angle[node()] = 0;
+	state().target_angle[node()] = angle();
 }
 
 void sprite::rotation_cycle(int16_t speed) {
 	stop_rotation();
 
-	speed_rotation = speed;
-	speed_rotation_cycle = speed;
-	m_rotation_cycle = true;
+	state().speed_angle[node()] = speed;
+	state().speed_angle_cycle[node()] = speed;
+	state().rotation_cycle[node()] = true;
+
+	wake();
 }
 
 void sprite::stop_rotation_cycle() {
-	speed_rotation_cycle = 0;
-	m_rotation_cycle = false;
+	state().speed_angle_cycle[node()] = 0;
+	state().rotation_cycle[node()] = false;
 }
 
 void sprite::stop_all() {
@@ -549,42 +638,44 @@ void sprite::stop_all() {
 }
 
 uint16_t sprite::height() const {
-	return(*surfaces_iter)->h;
+	return has_region() ? region().rect.h : 0;
 }
 
 uint16_t sprite::width() const {
-	return(*surfaces_iter)->w;
+	return has_region() ? region().rect.w : 0;
 }
 
-int16_t sprite::offset_x() const {
-	return gfx_object::offset_x();
+const surface_region& sprite::region() const {
+	return (*frames)[state().anim_frame[node()]];
 }
 
-void sprite::offset_x(int16_t offset) {
-	gfx_object::offset_x(offset);
-
-	if(surfaces_iter != surfaces[m_dir].end()) {
-		m_x_min = -(*surfaces_iter)->w - offset;
-		m_x_max = m_screen->w - offset;
-	}
+bool sprite::has_region() const {
+	return !frames->empty();
 }
 
-int16_t sprite::offset_y() const {
-	return gfx_object::offset_y();
+void sprite::clip(const std::vector<uint16_t>& durations) {
+	m_animation = templates->timed(m_animation, durations);
+
+	dir(m_dir);
 }
 
-void sprite::offset_y(int16_t offset) {
-	gfx_object::offset_y(offset);
+void sprite::image(const surface_region& region) {
+	templates->release(m_animation);
+	m_animation = templates->single(DIR_NONE, region);
 
-	if(surfaces_iter != surfaces[m_dir].end()) {
-		m_y_min = -(*surfaces_iter)->h - offset;
-		m_y_max = m_screen->h - offset;
-	}
+	dir(DIR_NONE);
 }
 
 void sprite::center() {
-	x((config->int_value("display_width") / 2) - (width() / 2));
-	y((config->int_value("display_height") / 2) - (height() / 2));
+	// Seen through a camera the middle of the screen is offset by the camera position
+
+	camera* viewed = gfx_object::view();
+
+	int32_t origin_x = viewed != NULL ? viewed->x() : 0;
+	int32_t origin_y = viewed != NULL ? viewed->y() : 0;
+
+	x(origin_x + (config->int_value("display_width") / 2) - (width() / 2));
+	y(origin_y + (config->int_value("display_height") / 2) - (height() / 2));
 }
 
 int16_t sprite::dir() {
@@ -592,38 +683,76 @@ int16_t sprite::dir() {
 }
 
 void sprite::dir(int16_t dir) {
+	node_state& state = this->state();
+	uint32_t node = this->node();
+
 	m_dir = dir;
-	m_anim_counter = 0;
+	frames = m_animation != NULL ? &m_animation->frames(m_dir) : &no_frames;
+
+	state.anim_counter[node] = 0;
+	state.anim_frame[node] = 0;
+	state.frame_count[node] = frames->size();
+
+	state.timed[node] = m_animation != NULL && m_animation->timed();
+	state.clip_start[node] = graph()->time();
+
+	state.moved[node] = 1; // The new frames may be a different height, which changes the depth order
 
-	surfaces_iter = surfaces[m_dir].begin();
+	wake();
 }
 
 void sprite::animate(bool animate) {
-	m_animate = animate;
+	node_state& state = this->state();
+	uint32_t node = this->node();
+
+	// Compared against the last step, not the last call, so switching off and on again within a frame keeps the clip going
+
+	if(state.timed[node]) {
+		if(animate && !state.animated[node])
+			state.clip_start[node] = graph()->time();
+		else if(!animate)
+			state.anim_frame[node] = 0;
+	}
+
+	state.animate[node] = animate;
+
+	wake();
 }
 
 uint16_t sprite::anim_wait() {
-	return m_anim_wait;
+	return state().anim_wait[node()];
 }
 
 void sprite::anim_wait(uint16_t anim_wait) {
-	m_anim_wait = anim_wait;
+	state().anim_wait[node()] = anim_wait;
+
+	wake();
 }
 
 uint8_t sprite::alpha() {
-	return current_alpha;
+	return state().alpha[node()];
 }
 
 void sprite::alpha(uint8_t alpha) {
-	current_alpha = alpha;
+	// display() sets the current alpha every frame, that alone must not keep the sprite awake
+
+	if(alpha != state().alpha[node()]) {
+		state().alpha[node()] = alpha;
+
+		wake();
+	}
 }
 
 int16_t sprite::angle() {
-	return m_angle;
+	return state().angle[node()];
 }
 
 void sprite::angle(int16_t angle) {
-	m_angle = angle % 360;
+	if(angle % 360 != state().angle[node()]) {
+		state().angle[node()] = angle % 360;
+
+		wake();
+	}
 }
 
 std::string sprite::text() {
@@ -641,6 +770,12 @@ std::string sprite::text() {
 }
 
 void sprite::text(const std::string &text) {
+	if(text == m_text && !text_lines.empty())
+		return; // Scripts tend to set their labels every frame
+
+	m_text = text;
+	m_wrap_width = -1; // Set again by the wrapping variant if it's the caller
+
 	std::string line = "";
 
 	if(m_font == NULL)
@@ -654,6 +789,9 @@ void sprite::text(const std::string &text) {
 		iter != text_lines.end();
 		iter++
 	) {
+		if((*iter).second != NULL)
+			counters->surfaces_freed++;
+
 		SDL_FreeSurface((*iter).second);
 	}
 
@@ -686,6 +824,11 @@ void sprite::text(std::string text, int16_t max_width) {
 	uint16_t break_pos = 0;
 	int width = 0;
 
+	if(max_width == m_wrap_width && text == m_wrap_text && !text_lines.empty())
+		return;
+
+	m_wrap_text = text;
+
 	if(m_font == NULL) {
 		std::string font_file = file(config->value("font"));
 		m_font = TTF_OpenFont(font_file.c_str(), config->int_value("font_size"));
@@ -758,12 +901,16 @@ void sprite::text(std::string text, int16_t max_width) {
 	new_text.append(line);
 
 	this->text(new_text);
+
+	m_wrap_width = max_width;
 }
 
 void sprite::font(const std::string &font_file, uint16_t size) {
 	TTF_CloseFont(m_font);
 	m_font = TTF_OpenFont(font_file.c_str(), size);
 
+	m_wrap_width = -1; // Wrapping depends on the font
+
 	text_surface_update = true;
 }
 
@@ -795,8 +942,29 @@ int16_t sprite::text_offset_y() const {
 	return m_text_offset_y;
 }
 
+frame_counters* sprite::stats() {
+	return counters;
+}
+
+void sprite::stats(frame_counters* stats) {
+	counters = stats;
+}
+
+animation_registry* sprite::registry() {
+	return templates;
+}
+
+void sprite::registry(animation_registry* registry) {
+	templates = registry;
+}
+
 bool sprite::coords_updated() {
-	bool ret = m_coords_updated;
-	m_coords_updated = false;
+	bool ret = state().moved[node()];
+	state().moved[node()] = 0;
 	return ret;
 }
+
+void sprite::depth() {
+	m_depth_layer = layer_id();
+	m_depth = has_region() ? world_y() + height() : std::numeric_limits<int32_t>::min();
+}
@@ -39,13 +39,16 @@
 
 #include "../surfacecache.h"
 #include "gfxobject.h"
+#include "animation.h"
 #include "../serializable.h"
+#include "../framecounters.h"
 
 
 class player;
 
 /**
  * Class that represents a graphical sprite with directions and animations.
+ * The per-frame state (movement, alpha, angle, animation) lives in the scene graph's node_state, the sprite keeps the rest.
  * Usually objects of this type are created by the Screen object, so there is usually no need to instantiate this class directly.
  */
 class sprite : public gfx_object, public serializable {
@@ -54,18 +57,10 @@ private:
 
     bool m_obstruct;
 
-    std::map<int, std::vector<SDL_Surface*> > surfaces;
-    std::map<int, std::vector<std::string> > files;
-
+    const animation* m_animation; // Shared with every sprite built from the same files
     int16_t m_dir;
-    uint16_t m_anim_counter;
-    uint16_t m_anim_wait;
-
-    uint8_t current_alpha, target_alpha, m_alpha_min, m_alpha_max;
-    bool m_alpha_cycle;
 
-    int16_t m_angle, m_target_angle;
-    bool m_rotation_cycle;
+    const std::vector<surface_region>* frames; // The frames of m_animation for m_dir
 
     std::vector<std::pair<std::string, SDL_Surface*> > text_lines;
     TTF_Font* m_font;
@@ -73,6 +68,14 @@ private:
 
     bool text_surface_update;
 
+    std::string m_text; // As last set, to skip setting the same text again
+    std::string m_wrap_text;
+    int16_t m_wrap_width;
+
+    SDL_Surface* rotated; // Last rotozoom result, reused while frame and angle stay the same
+    surface_region rotated_region;
+    int16_t rotated_angle;
+
     int16_t m_text_offset_x, m_text_offset_y;
 
     void init(SDL_Surface* screen, SDL_Surface* background, surface_cache* cache);
@@ -81,18 +84,33 @@ private:
 
     int16_t m_obs_offset_top, m_obs_offset_right, m_obs_offset_bottom, m_obs_offset_left;
 
+    uint16_t m_depth_layer; // Sort key as of the last depth(), the sprite_container must not see it change in place
+    int32_t m_depth;
+
+    static frame_counters* counters;
+    static animation_registry* templates;
+
 protected:
     SDL_Surface* m_screen;
     SDL_Surface* m_background;
 
     surface_cache* m_cache;
 
-    bool m_animate;
+    /**
+     * The current animation frame, only valid if has_region().
+     */
+    const surface_region& region() const;
+    bool has_region() const;
 
-    int16_t speed_alpha, speed_alpha_cycle;
-    int16_t speed_rotation, speed_rotation_cycle;
+    /**
+     * Replaces the animation with a single frame the sprite doesn't share, region stays owned by the caller.
+     */
+    void image(const surface_region& region);
 
-    std::vector<SDL_Surface*>::iterator surfaces_iter;
+    /**
+     * Returns a surface covering just the region, sharing its pixels. Free it unless it is the region's own surface.
+     */
+    static SDL_Surface* view(const surface_region& region);
 
 public:
     enum {
@@ -153,6 +171,30 @@ public:
      */
     void push_file(int16_t dir, const std::string &file);
 
+    /**
+     * Pushes several files at once, ending up like push_file for each of them in order.
+     * The shared animation is looked up or built once for the whole list instead of once per file.
+     * @param files
+     * 	Pairs of direction and file.
+     */
+    virtual void push_files(const file_list& files);
+
+    /**
+     * Pushes cells of a sprite sheet to the animation list for a specific direction.
+     * The sheet is loaded once and every frame is blitted from a part of it.
+     * @param dir
+     * 	The direction (e.g. DIR_N) for which the frames should be added.
+     * @param file
+     * 	The sheet image, a grid of equally sized cells.
+     * @param frame_w
+     * 	The width of a cell in pixels.
+     * @param frame_h
+     * 	The height of a cell in pixels.
+     * @param cells
+     * 	The cells to add in this order, numbered row by row from 0. Empty for all of them.
+     */
+    virtual void push_sheet(int16_t dir, const std::string &file, uint16_t frame_w, uint16_t frame_h, const std::vector<uint16_t>& cells);
+
     void obstruct(bool obstruct, int16_t offset_top = 0, int16_t offset_right = 0, int16_t offset_bottom = 0, int16_t offset_left = 0);
 
     uint16_t obstructed(player* player) const;
@@ -172,7 +214,7 @@ public:
      * @param y
      * 	The Y coordinate in pixels.
      */
-    void display(int16_t x, int16_t y);
+    void display(int32_t x, int32_t y);
 
     /**
      * Displays the sprite at a given position with a given alpha value.
@@ -184,7 +226,7 @@ public:
      * @param alpha
      * 	The alpha value from 0 (transparent) to 255 (opaque)
      */
-    void display(int16_t x, int16_t y, uint8_t alpha);
+    void display(int32_t x, int32_t y, uint8_t alpha);
 
     /**
      * Stops all movement of the sprite in X direction.
@@ -211,7 +253,7 @@ public:
      * @param speed
      * 	The speed in pixels per frame.
      */
-    void move(int16_t x, int16_t y, uint16_t speed);
+    void move(int32_t x, int32_t y, uint16_t speed);
 
     /**
      * Moves the sprite to a position relative to its current one, with a given speed.
@@ -223,7 +265,7 @@ public:
      * @param speed
      * 	The speed in pixels per frame.
      */
-    void move_relative(int16_t x, int16_t y, uint16_t speed);
+    void move_relative(int32_t x, int32_t y, uint16_t speed);
 
     /**
      * Stops all alpha fading initiated by alpha_to.
@@ -315,6 +357,13 @@ public:
 
     void animate(bool animate);
 
+    /**
+     * Makes the animation run on the clock, each frame showing for the given milliseconds.
+     * Durations repeat if there are fewer than frames. Frame rate and frameskip don't change the speed then,
+     * and the frame is only worked out for sprites on screen.
+     */
+    void clip(const std::vector<uint16_t>& durations);
+
     uint16_t anim_wait();
     void anim_wait(uint16_t anim_wait);
 
@@ -323,11 +372,6 @@ public:
 
     void center();
 
-    int16_t offset_x() const;
-    void offset_x(int16_t offset);
-    int16_t offset_y() const;
-    void offset_y(int16_t offset);
-
     uint8_t alpha();
     void alpha(uint8_t alpha);
     int16_t angle();
@@ -347,18 +391,29 @@ public:
 
     bool coords_updated();
 
-    struct less {
-	inline bool operator()(sprite* lhs, sprite* rhs) {
-	    if(lhs->surfaces_iter == lhs->surfaces[0].end() || rhs->surfaces_iter == rhs->surfaces[0].end())
-		return true;
+    /**
+     * Takes layer and bottom edge as the sort key, call only while the sprite is out of its sorted container.
+     */
+    void depth();
+
+    /**
+     * Where all sprites count their blits, culls and surfaces, owned by the screen.
+     */
+    static frame_counters* stats();
+    static void stats(frame_counters* stats);
 
-	    uint16_t llayer = lhs->layer_id();
-	    uint16_t rlayer = rhs->layer_id();
+    /**
+     * Where sprites get their shared animations from, owned by the screen.
+     */
+    static animation_registry* registry();
+    static void registry(animation_registry* registry);
 
+    struct less {
+	inline bool operator()(const sprite* lhs, const sprite* rhs) const {
             return(
-		llayer < rlayer ||
-                (llayer == rlayer &&
-                lhs->display_y() + lhs->height() < rhs->display_y() + rhs->height())
+		lhs->m_depth_layer < rhs->m_depth_layer ||
+                (lhs->m_depth_layer == rhs->m_depth_layer &&
+                lhs->m_depth < rhs->m_depth)
             );
 	}
     };
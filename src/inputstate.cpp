@@ -0,0 +1,203 @@
+/*
+	Copyright (c) 2010, Markus Wagner (bgld)
+	All rights reserved.
+
+	Redistribution and use in source and binary forms, with or without
+	modification, are permitted provided that the following conditions are
+	met:
+	- Redistributions of source code must retain the above copyright
+	  notice, this list of conditions and the following disclaimer.
+	- Redistributions in binary form must reproduce the above copyright
+	  notice, this list of conditions and the following disclaimer in the
+	  documentation and/or other materials provided with the distribution.
+	- Neither the name "fawesome" or "FawesomeEngine" nor the names of its contributors
+	  may be used to endorse or promote products derived from this software
+	  without specific prior written permission.
+
+	THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+	"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+	LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+	PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL MARKUS WAGNER BE
+	LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+	CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+	SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+	INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+	CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+	ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+	THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "inputstate.h"
+
+std::bitset<SDLK_LAST> input_state::m_down;
+std::bitset<SDLK_LAST> input_state::m_pressed;
+std::bitset<SDLK_LAST> input_state::m_released;
+
+int16_t input_state::m_axis[AXES];
+int8_t input_state::m_stick_before[2];
+
+uint32_t input_state::m_joy_down = 0;
+uint32_t input_state::m_joy_pressed = 0;
+uint32_t input_state::m_joy_released = 0;
+
+int16_t input_state::m_pointer_x = 0;
+int16_t input_state::m_pointer_y = 0;
+uint8_t input_state::m_buttons = 0;
+uint8_t input_state::m_buttons_pressed = 0;
+uint8_t input_state::m_buttons_released = 0;
+
+void input_state::begin_frame() {
+	m_pressed.reset();
+	m_released.reset();
+
+	m_joy_pressed = 0;
+	m_joy_released = 0;
+
+	m_buttons_pressed = 0;
+	m_buttons_released = 0;
+}
+
+void input_state::update(const SDL_Event& sdl_event) {
+	uint32_t bit;
+
+	switch(sdl_event.type) {
+	case SDL_KEYDOWN:
+		if(sdl_event.key.keysym.sym < SDLK_LAST) {
+			m_down.set(sdl_event.key.keysym.sym);
+			m_pressed.set(sdl_event.key.keysym.sym);
+		}
+		break;
+	case SDL_KEYUP:
+		if(sdl_event.key.keysym.sym < SDLK_LAST) {
+			m_down.reset(sdl_event.key.keysym.sym);
+			m_released.set(sdl_event.key.keysym.sym);
+		}
+		break;
+	case SDL_JOYAXISMOTION:
+		if(sdl_event.jaxis.axis < AXES) {
+			if(sdl_event.jaxis.axis < 2)
+				m_stick_before[sdl_event.jaxis.axis] = stick(sdl_event.jaxis.axis);
+
+			m_axis[sdl_event.jaxis.axis] = sdl_event.jaxis.value;
+		}
+		break;
+	case SDL_JOYBUTTONDOWN:
+		if(sdl_event.jbutton.button < JOY_BUTTONS) {
+			bit = 1u << sdl_event.jbutton.button;
+			m_joy_down |= bit;
+			m_joy_pressed |= bit;
+		}
+		break;
+	case SDL_JOYBUTTONUP:
+		if(sdl_event.jbutton.button < JOY_BUTTONS) {
+			bit = 1u << sdl_event.jbutton.button;
+			m_joy_down &= ~bit;
+			m_joy_released |= bit;
+		}
+		break;
+	case SDL_MOUSEMOTION:
+		m_pointer_x = sdl_event.motion.x;
+		m_pointer_y = sdl_event.motion.y;
+		break;
+	case SDL_MOUSEBUTTONDOWN:
+		m_pointer_x = sdl_event.button.x;
+		m_pointer_y = sdl_event.button.y;
+
+		if(sdl_event.button.button >= 1 && sdl_event.button.button <= 8) {
+			m_buttons |= SDL_BUTTON(sdl_event.button.button);
+			m_buttons_pressed |= SDL_BUTTON(sdl_event.button.button);
+		}
+		break;
+	case SDL_MOUSEBUTTONUP:
+		m_pointer_x = sdl_event.button.x;
+		m_pointer_y = sdl_event.button.y;
+
+		if(sdl_event.button.button >= 1 && sdl_event.button.button <= 8) {
+			m_buttons &= ~SDL_BUTTON(sdl_event.button.button);
+			m_buttons_released |= SDL_BUTTON(sdl_event.button.button);
+		}
+		break;
+	}
+}
+
+bool input_state::down(SDLKey key) {
+	return key < SDLK_LAST && m_down.test(key);
+}
+
+bool input_state::pressed(SDLKey key) {
+	return key < SDLK_LAST && m_pressed.test(key);
+}
+
+bool input_state::released(SDLKey key) {
+	return key < SDLK_LAST && m_released.test(key);
+}
+
+bool input_state::held(SDLKey key) {
+	if(down(key))
+		return true;
+
+	switch(key) {
+	case SDLK_UP:
+		return stick(1) < 0;
+	case SDLK_DOWN:
+		return stick(1) > 0;
+	case SDLK_LEFT:
+		return stick(0) < 0;
+	case SDLK_RIGHT:
+		return stick(0) > 0;
+	default:
+		return false;
+	}
+}
+
+int16_t input_state::axis(uint8_t axis) {
+	return axis < AXES ? m_axis[axis] : 0;
+}
+
+int8_t input_state::stick(uint8_t axis) {
+	if(axis >= AXES)
+		return 0;
+
+	if(m_axis[axis] < -DEAD_ZONE)
+		return -1;
+	else if(m_axis[axis] > DEAD_ZONE)
+		return 1;
+
+	return 0;
+}
+
+int8_t input_state::stick_before(uint8_t axis) {
+	return axis < 2 ? m_stick_before[axis] : 0;
+}
+
+bool input_state::joy_down(uint8_t button) {
+	return button < JOY_BUTTONS && (m_joy_down & (1u << button));
+}
+
+bool input_state::joy_pressed(uint8_t button) {
+	return button < JOY_BUTTONS && (m_joy_pressed & (1u << button));
+}
+
+bool input_state::joy_released(uint8_t button) {
+	return button < JOY_BUTTONS && (m_joy_released & (1u << button));
+}
+
+int16_t input_state::pointer_x() {
+	return m_pointer_x;
+}
+
+int16_t input_state::pointer_y() {
+	return m_pointer_y;
+}
+
+bool input_state::button(uint8_t button) {
+	return button >= 1 && button <= 8 && (m_buttons & SDL_BUTTON(button));
+}
+
+bool input_state::button_pressed(uint8_t button) {
+	return button >= 1 && button <= 8 && (m_buttons_pressed & SDL_BUTTON(button));
+}
+
+bool input_state::button_released(uint8_t button) {
+	return button >= 1 && button <= 8 && (m_buttons_released & SDL_BUTTON(button));
+}
@@ -0,0 +1,108 @@
+/*
+        Copyright (c) 2010, Markus Wagner (bgld)
+        All rights reserved.
+
+        Redistribution and use in source and binary forms, with or without
+        modification, are permitted provided that the following conditions are
+        met:
+        - Redistributions of source code must retain the above copyright
+          notice, this list of conditions and the following disclaimer.
+        - Redistributions in binary form must reproduce the above copyright
+          notice, this list of conditions and the following disclaimer in the
+          documentation and/or other materials provided with the distribution.
+        - Neither the name "fawesome" or "FawesomeEngine" nor the names of its contributors
+          may be used to endorse or promote products derived from this software
+          without specific prior written permission.
+
+        THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+        "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+        LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+        PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL MARKUS WAGNER BE
+        LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+        CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+        SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+        INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+        CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+        ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+        THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef INPUTSTATE_H
+#define INPUTSTATE_H
+
+#include <bitset>
+#include <stdint.h>
+#include <SDL/SDL.h>
+
+
+/**
+ * Snapshot of the input devices, fed by the main loop with every event it polls.
+ * Meant for gameplay code that would rather ask "is this held?" than count presses and releases.
+ * Edge flags are kept per frame: pressed() and released() are true if the transition happened
+ * since the last begin_frame(), so a tap within one frame shows up in both.
+ * The first two joystick axes count as the arrow keys in held() and stick().
+ */
+class input_state {
+public:
+    static const uint8_t AXES = 8;
+    static const uint8_t JOY_BUTTONS = 32;
+    static const int16_t DEAD_ZONE = 16383;
+private:
+    static std::bitset<SDLK_LAST> m_down;
+    static std::bitset<SDLK_LAST> m_pressed;
+    static std::bitset<SDLK_LAST> m_released;
+
+    static int16_t m_axis[AXES];
+    static int8_t m_stick_before[2];
+
+    static uint32_t m_joy_down;
+    static uint32_t m_joy_pressed;
+    static uint32_t m_joy_released;
+
+    static int16_t m_pointer_x;
+    static int16_t m_pointer_y;
+    static uint8_t m_buttons;
+    static uint8_t m_buttons_pressed;
+    static uint8_t m_buttons_released;
+public:
+    /**
+     * Clears the edge flags, call once per frame before polling.
+     */
+    static void begin_frame();
+
+    static void update(const SDL_Event& sdl_event);
+
+    static bool down(SDLKey key);
+    static bool pressed(SDLKey key);
+    static bool released(SDLKey key);
+
+    /**
+     * Key down, or for the arrow keys also the stick pushed that way.
+     */
+    static bool held(SDLKey key);
+
+    static int16_t axis(uint8_t axis);
+
+    /**
+     * -1, 0 or 1 depending on which side of the dead zone the axis is on,
+     * stick_before() is what it was before the last event for that axis.
+     */
+    static int8_t stick(uint8_t axis);
+    static int8_t stick_before(uint8_t axis);
+
+    static bool joy_down(uint8_t button);
+    static bool joy_pressed(uint8_t button);
+    static bool joy_released(uint8_t button);
+
+    static int16_t pointer_x();
+    static int16_t pointer_y();
+
+    /**
+     * Pointer buttons by number like pointer_event::button(), e.g. button(SDL_BUTTON_RIGHT).
+     */
+    static bool button(uint8_t button);
+    static bool button_pressed(uint8_t button);
+    static bool button_released(uint8_t button);
+};
+
+#endif // INPUTSTATE_H
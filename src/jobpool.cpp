@@ -0,0 +1,164 @@
+/*
+	Copyright (c) 2010, Markus Wagner (bgld)
+	All rights reserved.
+
+	Redistribution and use in source and binary forms, with or without
+	modification, are permitted provided that the following conditions are
+	met:
+	- Redistributions of source code must retain the above copyright
+	  notice, this list of conditions and the following disclaimer.
+	- Redistributions in binary form must reproduce the above copyright
+	  notice, this list of conditions and the following disclaimer in the
+	  documentation and/or other materials provided with the distribution.
+	- Neither the name "fawesome" or "FawesomeEngine" nor the names of its contributors
+	  may be used to endorse or promote products derived from this software
+	  without specific prior written permission.
+
+	THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+	"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+	LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+	PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL MARKUS WAGNER BE
+	LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+	CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+	SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+	INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+	CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+	ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+	THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "jobpool.h"
+
+#ifdef WIN32
+#        include <windows.h>
+#else
+#        include <unistd.h>
+#endif
+
+job_pool::job_pool(uint16_t threads) {
+	mutex = SDL_CreateMutex();
+	work_ready = SDL_CreateCond();
+	work_done = SDL_CreateCond();
+
+	m_job = NULL;
+	m_rows = 0;
+	m_bands = 0;
+	next_band = 0;
+	finished_bands = 0;
+
+	quit = false;
+
+	if(threads == 0)
+		threads = cores() - 1;
+
+	for(uint16_t i = 0; i < threads; i++) {
+		SDL_Thread* thread = SDL_CreateThread(worker, this);
+
+		if(thread != NULL)
+			workers.push_back(thread);
+	}
+}
+
+job_pool::~job_pool() {
+	SDL_LockMutex(mutex);
+	quit = true;
+	SDL_CondBroadcast(work_ready);
+	SDL_UnlockMutex(mutex);
+
+	for(
+		std::vector<SDL_Thread*>::iterator iter = workers.begin();
+		iter != workers.end();
+		iter++
+	) {
+		SDL_WaitThread(*iter, NULL);
+	}
+
+	SDL_DestroyCond(work_done);
+	SDL_DestroyCond(work_ready);
+	SDL_DestroyMutex(mutex);
+}
+
+int job_pool::worker(void* data) {
+	job_pool* pool = (job_pool*)data;
+
+	SDL_LockMutex(pool->mutex);
+
+	while(true) {
+		while(!pool->quit && (pool->m_job == NULL || pool->next_band >= pool->m_bands))
+			SDL_CondWait(pool->work_ready, pool->mutex);
+
+		if(pool->quit)
+			break;
+
+		pool->process_band(pool->next_band++);
+	}
+
+	SDL_UnlockMutex(pool->mutex);
+
+	return 0;
+}
+
+void job_pool::process_band(uint16_t band) {
+	// Called with the mutex locked, the job itself runs unlocked
+
+	band_job* job = m_job;
+	uint16_t first = (uint32_t)m_rows * band / m_bands;
+	uint16_t end = (uint32_t)m_rows * (band + 1) / m_bands;
+
+	SDL_UnlockMutex(mutex);
+
+	job->process(first, end);
+
+	SDL_LockMutex(mutex);
+
+	finished_bands++;
+
+	if(finished_bands == m_bands)
+		SDL_CondSignal(work_done);
+}
+
+void job_pool::run(band_job* job, uint16_t rows) {
+	if(workers.empty() || rows < 2 * (workers.size() + 1)) {
+		job->process(0, rows);
+		return;
+	}
+
+	SDL_LockMutex(mutex);
+
+	m_job = job;
+	m_rows = rows;
+	m_bands = workers.size() + 1;
+	next_band = 0;
+	finished_bands = 0;
+
+	SDL_CondBroadcast(work_ready);
+
+	// Help out instead of idling
+
+	while(next_band < m_bands)
+		process_band(next_band++);
+
+	while(finished_bands < m_bands)
+		SDL_CondWait(work_done, mutex);
+
+	m_job = NULL;
+
+	SDL_UnlockMutex(mutex);
+}
+
+uint16_t job_pool::threads() const {
+	return workers.size();
+}
+
+uint16_t job_pool::cores() {
+#ifdef WIN32
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+
+	long count = info.dwNumberOfProcessors;
+#else
+	long count = sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+
+	return count > 0 ? count : 1;
+}
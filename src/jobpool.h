@@ -0,0 +1,90 @@
+/*
+        Copyright (c) 2010, Markus Wagner (bgld)
+        All rights reserved.
+
+        Redistribution and use in source and binary forms, with or without
+        modification, are permitted provided that the following conditions are
+        met:
+        - Redistributions of source code must retain the above copyright
+          notice, this list of conditions and the following disclaimer.
+        - Redistributions in binary form must reproduce the above copyright
+          notice, this list of conditions and the following disclaimer in the
+          documentation and/or other materials provided with the distribution.
+        - Neither the name "fawesome" or "FawesomeEngine" nor the names of its contributors
+          may be used to endorse or promote products derived from this software
+          without specific prior written permission.
+
+        THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+        "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+        LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+        PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL MARKUS WAGNER BE
+        LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+        CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+        SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+        INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+        CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+        ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+        THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef JOBPOOL_H
+#define JOBPOOL_H
+
+#include <vector>
+#include <stdint.h>
+#include <SDL/SDL_thread.h>
+#include <SDL/SDL_mutex.h>
+
+
+/**
+ * Work that can be split into independent horizontal bands of rows.
+ */
+class band_job {
+public:
+    virtual ~band_job() {}
+
+    /**
+     * Processes the rows from first up to, but not including, end. Called concurrently for disjoint bands.
+     */
+    virtual void process(uint16_t first, uint16_t end) = 0;
+};
+
+/**
+ * A fixed set of worker threads that split band jobs between themselves and the calling thread.
+ * run returns once every band is done, so the caller can use the results right away.
+ */
+class job_pool {
+private:
+    std::vector<SDL_Thread*> workers;
+
+    SDL_mutex* mutex;
+    SDL_cond* work_ready;
+    SDL_cond* work_done;
+
+    band_job* m_job;
+    uint16_t m_rows;
+    uint16_t m_bands;
+    uint16_t next_band;
+    uint16_t finished_bands;
+
+    bool quit;
+
+    static int worker(void* data);
+
+    void process_band(uint16_t band);
+public:
+    /**
+     * @param threads
+     * 	The number of worker threads in addition to the calling thread, 0 to detect from the number of cores.
+     */
+    job_pool(uint16_t threads);
+    ~job_pool();
+
+    void run(band_job* job, uint16_t rows);
+
+    uint16_t threads() const;
+
+    static uint16_t cores();
+};
+
+#endif // JOBPOOL_H
@@ -53,18 +53,21 @@
 #include "events/controllerpressevent.h"
 #include "events/controllerreleaseevent.h"
 #include "events/pointerevent.h"
+#include "events/pointermoveevent.h"
 #include "audioplayer.h"
 #include "configfile.h"
 #include "serializable.h"
 #include "gfx/draggablesprite.h"
 #include "gfx/splash.h"
 #include "file.h"
+#include "profiler.h"
+#include "statslog.h"
+#include "inputstate.h"
 
 
 config_file* config;
 
-int16_t faked_key_presses;
-int16_t faked_key_releases;
+bool raw_motion; // Any handler wants every motion sample, checked once per frame
 
 void message(std::string msg, bool error = false) {
 	if(error) {
@@ -149,77 +152,57 @@ void save_game(tcl_bind* bind, const std::string& file, serializable* master) {
 	deflateEnd(&zstream);
 }
 
+void flush_motion(event_queue* queue, tcl_bind* bind) {
+	SDL_Event motion;
+
+	if(!queue->coalesced(motion))
+		return;
+
+	pointer_move_event pointmove(motion, bind);
+
+	if(bind->call_event_code("pointmove", pointmove.var()) == false)
+		queue->handle(&pointmove, false);
+}
+
 void handle_sdl_event(const SDL_Event& sdl_event, event_queue* queue, tcl_bind* bind) {
 	controller_press_event* contpress;
 	controller_release_event* contrelease;
 	pointer_press_event* pointpress;
 	pointer_release_event* pointrelease;
-	pointer_move_event* pointmove;
 
 	SDL_Event fake_event;
-	SDL_Event first_fake;
-	SDL_Event second_fake;
+	SDLKey arrows[2];
+	int8_t before, after;
 
 	switch(sdl_event.type) {
 	case SDL_JOYAXISMOTION:
-		// We're faking keypresses here, cleanest solution I could think of XD
-
-		if(sdl_event.jaxis.value < -16383 || sdl_event.jaxis.value > 16383) {
-			switch(sdl_event.jaxis.axis) {
-			case 0:
-				fake_event.key.keysym.sym = sdl_event.jaxis.value < 0 ? SDLK_LEFT : SDLK_RIGHT;
-				break;
-			case 1:
-				fake_event.key.keysym.sym = sdl_event.jaxis.value < 0 ? SDLK_UP : SDLK_DOWN;
-				break;
-			default:
-				fake_event.key.keysym.sym = (SDLKey)0;
-			}
-
-			second_fake = first_fake = fake_event;
+		// We're faking keypresses here, the snapshot already knows where the stick pointed before this event
 
-			if(faked_key_presses > 0) {
-				first_fake.type = SDL_KEYUP;
-				faked_key_releases++;
-				faked_key_presses--;
-			}
+		if(sdl_event.jaxis.axis > 1)
+			break;
 
-			if(faked_key_presses <= faked_key_releases) {
-				second_fake.type = SDL_KEYDOWN;
-				faked_key_presses++;
-				faked_key_releases--;
-			}
-		} else {
-			switch(sdl_event.jaxis.axis) {
-			case 0:
-				fake_event.key.keysym.sym = sdl_event.jaxis.value >= 0 ? SDLK_LEFT : SDLK_RIGHT;
-				break;
-			case 1:
-				fake_event.key.keysym.sym = sdl_event.jaxis.value >= 0 ? SDLK_UP : SDLK_DOWN;
-				break;
-			default:
-				fake_event.key.keysym.sym = (SDLKey)0;
-			}
+		before = input_state::stick_before(sdl_event.jaxis.axis);
+		after = input_state::stick(sdl_event.jaxis.axis);
 
-			second_fake = first_fake = fake_event;
+		if(before == after)
+			break;
 
-			if(faked_key_presses <= faked_key_releases) {
-				second_fake.type = SDL_KEYDOWN;
-				faked_key_presses++;
-				faked_key_releases--;
-			}
+		arrows[0] = sdl_event.jaxis.axis == 0 ? SDLK_LEFT : SDLK_UP;
+		arrows[1] = sdl_event.jaxis.axis == 0 ? SDLK_RIGHT : SDLK_DOWN;
 
-			if(faked_key_presses > 0) {
-				first_fake.type = SDL_KEYUP;
-				faked_key_releases++;
-				faked_key_presses--;
-			}
+		memset(&fake_event, 0, sizeof(fake_event));
 
+		if(before != 0) {
+			fake_event.type = SDL_KEYUP;
+			fake_event.key.keysym.sym = arrows[before > 0];
+			handle_sdl_event(fake_event, queue, bind);
 		}
 
-		handle_sdl_event(first_fake, queue, bind);
-		handle_sdl_event(second_fake, queue, bind);
-
+		if(after != 0) {
+			fake_event.type = SDL_KEYDOWN;
+			fake_event.key.keysym.sym = arrows[after > 0];
+			handle_sdl_event(fake_event, queue, bind);
+		}
 		break;
 	case SDL_KEYDOWN:
 	case SDL_JOYBUTTONDOWN:
@@ -236,22 +219,30 @@ void handle_sdl_event(const SDL_Event& sdl_event, event_queue* queue, tcl_bind*
 			queue->handle(contrelease);
 		break;
 	case SDL_MOUSEBUTTONDOWN:
+		flush_motion(queue, bind); // Whoever gets the press should have seen the pointer get there
+
 		pointpress = new pointer_press_event(sdl_event, bind);
 
 		if(bind->call_event_code("pointpress", pointpress->var()) == false)
 			queue->handle(pointpress);
 		break;
 	case SDL_MOUSEBUTTONUP:
+		flush_motion(queue, bind);
+
 		pointrelease = new pointer_release_event(sdl_event, bind);
 
 		if(bind->call_event_code("pointrelease", pointrelease->var()) == false)
 			queue->handle(pointrelease);
 		break;
 	case SDL_MOUSEMOTION:
-		pointmove = new pointer_move_event(sdl_event, bind);
+		// Summed up and handed out once per frame, except to the handlers that want every sample
+
+		queue->coalesce(sdl_event);
 
-		if(bind->call_event_code("pointmove", pointmove->var()) == false)
-			queue->handle(pointmove);
+		if(raw_motion) {
+			pointer_move_event pointmove(sdl_event, bind);
+			queue->handle(&pointmove, true);
+		}
 		break;
 	}
 }
@@ -261,9 +252,6 @@ int main(int argc, char* argv[]) {
 		FreeConsole(); // We can't just link with -Wl,-subsystem,windows or something like that because that breaks Tcl
 	#endif
 
-	faked_key_presses = 0;
-	faked_key_releases = 0;
-
 	if(argc == 2) {
 		file::path(argv[1]);
 	} else if(argc > 2) {
@@ -280,6 +268,8 @@ int main(int argc, char* argv[]) {
 
 	message("Success!");
 
+	profiler::init(config->bool_value("profile"), config->bool_value("profile_graph"));
+
 
 	message("Initializing SDL...");
 
@@ -353,6 +343,16 @@ int main(int argc, char* argv[]) {
 	mouse_cursor* cursor = screen_obj->new_sprite<mouse_cursor>("files/img/cursor.png");
 	cursor->layer_id(500);
 
+	stats_log* log = NULL;
+
+	if(config->value("stats_log") != "") {
+		try {
+			log = new stats_log(file(config->value("stats_log")));
+		} catch(std::runtime_error e) {
+			exception_message(e, "");
+		}
+	}
+
 	bool game_running = true;
 
 	bool game_active = true;
@@ -360,28 +360,51 @@ int main(int argc, char* argv[]) {
 
 	while(game_running) {
 		if(game_active) {
-			while(SDL_PollEvent(&sdl_event)) {
-				switch(sdl_event.type) {
-				case SDL_ACTIVEEVENT:
-					if(!sdl_event.active.gain)
-						game_active = false;
-					break;
-				case SDL_QUIT:
-					game_running = false;
-					break;
-				case SDL_KEYUP:
-					if(sdl_event.key.keysym.sym == SDLK_ESCAPE) {
-						save_game(&bind, "test.faw", screen_obj);
+			profiler::frame();
+
+			{
+				profile_scope scope(profiler::PHASE_EVENTS);
+
+				raw_motion = queue->raw_handlers();
+
+				input_state::begin_frame();
+
+				while(SDL_PollEvent(&sdl_event)) {
+					input_state::update(sdl_event);
+
+					switch(sdl_event.type) {
+					case SDL_ACTIVEEVENT:
+						if(!sdl_event.active.gain)
+							game_active = false;
+						break;
+					case SDL_QUIT:
 						game_running = false;
+						break;
+					case SDL_KEYUP:
+						if(sdl_event.key.keysym.sym == SDLK_ESCAPE) {
+							save_game(&bind, "test.faw", screen_obj);
+							game_running = false;
+						}
+					default:
+						handle_sdl_event(sdl_event, queue, &bind);
 					}
-				default:
-					handle_sdl_event(sdl_event, queue, &bind);
 				}
+
+				flush_motion(queue, &bind);
 			}
 
-			bind.call_event_code("frame");
+			{
+				profile_scope scope(profiler::PHASE_SCRIPT);
+
+				bind.call_event_code("frame");
+			}
 
 			screen_obj->display();
+
+			player->update();
+
+			if(log != NULL)
+				log->update(screen_obj, queue, &bind);
 		} else {
 			// Restore game if minimized/lost focus
 
@@ -402,8 +425,14 @@ int main(int argc, char* argv[]) {
 		}
 	}
 
+	profiler::dump(file(config->value("profile_trace")));
+
+	delete log;
+
 	delete screen_obj;
 
+	delete player;
+
 	SDL_Quit();
 
 	return EXIT_SUCCESS;
@@ -0,0 +1,430 @@
+/*
+	Copyright (c) 2010, Markus Wagner (bgld)
+	All rights reserved.
+
+	Redistribution and use in source and binary forms, with or without
+	modification, are permitted provided that the following conditions are
+	met:
+	- Redistributions of source code must retain the above copyright
+	  notice, this list of conditions and the following disclaimer.
+	- Redistributions in binary form must reproduce the above copyright
+	  notice, this list of conditions and the following disclaimer in the
+	  documentation and/or other materials provided with the distribution.
+	- Neither the name "fawesome" or "FawesomeEngine" nor the names of its contributors
+	  may be used to endorse or promote products derived from this software
+	  without specific prior written permission.
+
+	THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+	"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+	LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+	PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL MARKUS WAGNER BE
+	LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+	CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+	SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+	INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+	CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+	ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+	THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "musicstream.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <stdexcept>
+
+#include "globals.h"
+#include "filenotfoundexception.h"
+
+
+// How long the worker sleeps while the ring is full, the audio thread never wakes it
+static const uint32_t POLL_TICKS = 10;
+
+static uint16_t le16(const uint8_t* bytes) {
+	return bytes[0] | bytes[1] << 8;
+}
+
+static uint32_t le32(const uint8_t* bytes) {
+	return bytes[0] | bytes[1] << 8 | bytes[2] << 16 | (uint32_t)bytes[3] << 24;
+}
+
+/**
+ * Reads uncompressed PCM WAV files a block at a time, resampled to stereo at the device rate.
+ */
+class wav_decoder {
+private:
+	std::string m_name;
+	FILE* m_file;
+
+	uint32_t data_start;
+	uint32_t data_length;
+	uint32_t remaining; // Bytes of data not read yet
+
+	uint16_t channels;
+	uint16_t bits;
+	uint16_t frame_bytes;
+
+	bool m_loop;
+
+	uint8_t raw[4096];
+	uint32_t raw_length;
+	uint32_t raw_position;
+
+	// Linear resampling in 16.16 fixed point, carried over from one read to the next
+	uint32_t step;
+	uint32_t phase;
+	int16_t current[2];
+	int16_t next[2];
+	bool m_ended;
+
+	void fail(const std::string& reason) {
+		fclose(m_file);
+		throw std::runtime_error(m_name + ": " + reason);
+	}
+
+	bool source_frame(int16_t* frame) {
+		if(raw_position == raw_length) {
+			if(remaining == 0) {
+				if(!m_loop)
+					return false;
+
+				// Straight back to the start, without a gap
+
+				fseek(m_file, data_start, SEEK_SET);
+				remaining = data_length;
+			}
+
+			uint32_t wanted = std::min<uint32_t>(sizeof(raw) - sizeof(raw) % frame_bytes, remaining);
+
+			raw_length = fread(raw, 1, wanted, m_file);
+			raw_length -= raw_length % frame_bytes;
+			raw_position = 0;
+
+			remaining = raw_length < wanted ? 0 : remaining - wanted; // Cut short files end early
+
+			if(raw_length == 0)
+				return false;
+		}
+
+		const uint8_t* sample = raw + raw_position;
+
+		for(uint8_t channel = 0; channel < 2; channel++) {
+			uint16_t source = channel < channels ? channel : 0; // Mono goes to both sides
+
+			if(bits == 8)
+				frame[channel] = (int16_t)((sample[source] - 128) << 8);
+			else
+				frame[channel] = (int16_t)le16(sample + source * 2);
+		}
+
+		raw_position += frame_bytes;
+
+		return true;
+	}
+public:
+	wav_decoder(const std::string& name, uint32_t rate, bool loop) {
+		m_name = name;
+		m_loop = loop;
+
+		m_file = fopen(name.c_str(), "rb");
+
+		if(m_file == NULL)
+			throw file_not_found_exception(name);
+
+		uint8_t header[12];
+
+		size_t header_length = fread(header, 1, sizeof(header), m_file);
+
+		if(header_length >= 4 && memcmp(header, "MThd", 4) == 0)
+			fail("MIDI isn't supported, convert it to WAV");
+
+		if(header_length != sizeof(header))
+			fail("too short");
+
+		if(memcmp(header, "RIFF", 4) != 0 || memcmp(header + 8, "WAVE", 4) != 0)
+			fail("not a WAV file");
+
+		// Walk the chunks up to the data, picking up the format on the way
+
+		uint32_t source_rate = 0;
+		frame_bytes = 0;
+
+		while(true) {
+			uint8_t chunk[8];
+
+			if(fread(chunk, 1, sizeof(chunk), m_file) != sizeof(chunk))
+				fail("no audio data");
+
+			uint32_t size = le32(chunk + 4);
+
+			if(memcmp(chunk, "fmt ", 4) == 0) {
+				uint8_t format[16];
+
+				if(size < sizeof(format) || fread(format, 1, sizeof(format), m_file) != sizeof(format))
+					fail("broken format");
+
+				if(le16(format) != 1)
+					fail("only uncompressed PCM is supported");
+
+				channels = le16(format + 2);
+				source_rate = le32(format + 4);
+				bits = le16(format + 14);
+
+				if(channels == 0 || source_rate == 0 || (bits != 8 && bits != 16))
+					fail("only 8 and 16 bit PCM is supported");
+
+				frame_bytes = channels * bits / 8;
+
+				fseek(m_file, size - sizeof(format) + (size & 1), SEEK_CUR);
+			} else if(memcmp(chunk, "data", 4) == 0) {
+				if(frame_bytes == 0)
+					fail("audio data before its format");
+
+				data_start = ftell(m_file);
+				data_length = size - size % frame_bytes;
+				break;
+			} else {
+				fseek(m_file, size + (size & 1), SEEK_CUR);
+			}
+		}
+
+		remaining = data_length;
+		raw_length = 0;
+		raw_position = 0;
+
+		step = (uint32_t)(((uint64_t)source_rate << 16) / rate);
+		phase = 0;
+
+		m_ended = !source_frame(current);
+
+		if(!m_ended && !source_frame(next))
+			memcpy(next, current, sizeof(next));
+	}
+
+	~wav_decoder() {
+		fclose(m_file);
+	}
+
+	/**
+	 * Fills out with up to frames stereo frames, fewer once the end is reached.
+	 */
+	uint32_t read(int16_t* out, uint32_t frames) {
+		uint32_t done = 0;
+
+		while(done < frames && !m_ended) {
+			for(uint8_t channel = 0; channel < 2; channel++)
+				out[done * 2 + channel] = current[channel] + (((next[channel] - current[channel]) * (int32_t)(phase >> 1)) >> 15);
+
+			done++;
+			phase += step;
+
+			while(phase >= 0x10000) {
+				phase -= 0x10000;
+				memcpy(current, next, sizeof(current));
+
+				if(!source_frame(next)) {
+					m_ended = true;
+					break;
+				}
+			}
+		}
+
+		return done;
+	}
+
+	bool ended() const {
+		return m_ended;
+	}
+};
+
+music_stream::music_stream(uint32_t rate) {
+	read_position = 0;
+	write_position = 0;
+
+	m_rate = rate;
+
+	request_pending = false;
+	request_fade = 0;
+	request_loop = false;
+	quit = false;
+
+	playing = NULL;
+	fading = NULL;
+	fade_frames = 0;
+	fade_position = 0;
+
+	incoming.resize(CHUNK_FRAMES * 2);
+	outgoing.resize(CHUNK_FRAMES * 2);
+
+	mutex = SDL_CreateMutex();
+	wake = SDL_CreateCond();
+
+	worker = SDL_CreateThread(work, this);
+}
+
+music_stream::~music_stream() {
+	SDL_LockMutex(mutex);
+	quit = true;
+	SDL_CondSignal(wake);
+	SDL_UnlockMutex(mutex);
+
+	SDL_WaitThread(worker, NULL);
+
+	delete playing;
+	delete fading;
+
+	SDL_DestroyCond(wake);
+	SDL_DestroyMutex(mutex);
+}
+
+int music_stream::work(void* data) {
+	music_stream* stream = (music_stream*)data;
+
+	SDL_LockMutex(stream->mutex);
+
+	while(!stream->quit) {
+		if(stream->request_pending) {
+			stream->take_request();
+			continue;
+		}
+
+		bool room = RING_FRAMES - (stream->write_position - stream->read_position) >= CHUNK_FRAMES;
+
+		if(room && (stream->playing != NULL || stream->fading != NULL)) {
+			SDL_UnlockMutex(stream->mutex);
+			stream->produce();
+			SDL_LockMutex(stream->mutex);
+			continue;
+		}
+
+		SDL_CondWaitTimeout(stream->wake, stream->mutex, POLL_TICKS);
+	}
+
+	SDL_UnlockMutex(stream->mutex);
+
+	return 0;
+}
+
+void music_stream::take_request() {
+	std::string file = request_file;
+	uint32_t fade = request_fade;
+	bool loop = request_loop;
+
+	request_pending = false;
+
+	// Opening the file may take a while, the game thread can leave the next request meanwhile
+
+	SDL_UnlockMutex(mutex);
+
+	wav_decoder* next = NULL;
+
+	if(!file.empty()) {
+		try {
+			next = new wav_decoder(file, m_rate, loop);
+		} catch(std::runtime_error e) {
+			message(std::string("Can't play music ") + e.what(), false);
+		}
+	}
+
+	// A track still fading out from before is cut off
+
+	delete fading;
+
+	fading = playing;
+	playing = next;
+
+	fade_frames = (uint64_t)fade * m_rate / 1000;
+	fade_position = 0;
+
+	if(fade_frames == 0) {
+		delete fading;
+		fading = NULL;
+	}
+
+	SDL_LockMutex(mutex);
+}
+
+void music_stream::produce() {
+	int16_t* in = &incoming[0];
+	int16_t* out = &outgoing[0];
+
+	uint32_t frames = 0;
+
+	if(playing != NULL) {
+		frames = playing->read(in, CHUNK_FRAMES);
+
+		if(playing->ended()) {
+			delete playing;
+			playing = NULL;
+		}
+	}
+
+	memset(in + frames * 2, 0, (CHUNK_FRAMES - frames) * 2 * sizeof(int16_t));
+
+	if(fading != NULL) {
+		uint32_t fading_frames = fading->read(out, CHUNK_FRAMES);
+		memset(out + fading_frames * 2, 0, (CHUNK_FRAMES - fading_frames) * 2 * sizeof(int16_t));
+
+		for(uint32_t i = 0; i < CHUNK_FRAMES; i++) {
+			int32_t gain = fade_position < fade_frames ? (int32_t)(((uint64_t)fade_position << 8) / fade_frames) : 256;
+
+			in[i * 2] = (in[i * 2] * gain + out[i * 2] * (256 - gain)) >> 8;
+			in[i * 2 + 1] = (in[i * 2 + 1] * gain + out[i * 2 + 1] * (256 - gain)) >> 8;
+
+			fade_position++;
+		}
+
+		if(fade_position >= fade_frames || fading->ended()) {
+			delete fading;
+			fading = NULL;
+		}
+	}
+
+	// Copy in two parts if the ring wraps around
+
+	uint32_t write = write_position;
+	uint32_t offset = write % RING_FRAMES;
+	uint32_t first = RING_FRAMES - offset;
+
+	if(first > CHUNK_FRAMES)
+		first = CHUNK_FRAMES;
+
+	memcpy(ring + offset * 2, in, first * 2 * sizeof(int16_t));
+	memcpy(ring, in + first * 2, (CHUNK_FRAMES - first) * 2 * sizeof(int16_t));
+
+	__sync_synchronize();
+	write_position = write + CHUNK_FRAMES;
+}
+
+void music_stream::play(const std::string& file, uint32_t fade, bool loop) {
+	SDL_LockMutex(mutex);
+
+	request_pending = true;
+	request_file = file;
+	request_fade = fade;
+	request_loop = loop;
+
+	SDL_CondSignal(wake);
+	SDL_UnlockMutex(mutex);
+}
+
+void music_stream::mix(int32_t* mixed, uint32_t frames, int32_t volume) {
+	uint32_t read = read_position;
+	uint32_t available = write_position - read;
+
+	__sync_synchronize();
+
+	if(frames > available)
+		frames = available;
+
+	for(uint32_t i = 0; i < frames; i++) {
+		uint32_t offset = ((read + i) % RING_FRAMES) * 2;
+
+		mixed[i * 2] += (ring[offset] * volume) >> 8;
+		mixed[i * 2 + 1] += (ring[offset + 1] * volume) >> 8;
+	}
+
+	__sync_synchronize();
+	read_position = read + frames;
+}
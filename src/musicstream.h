@@ -0,0 +1,102 @@
+/*
+        Copyright (c) 2010, Markus Wagner (bgld)
+        All rights reserved.
+
+        Redistribution and use in source and binary forms, with or without
+        modification, are permitted provided that the following conditions are
+        met:
+        - Redistributions of source code must retain the above copyright
+          notice, this list of conditions and the following disclaimer.
+        - Redistributions in binary form must reproduce the above copyright
+          notice, this list of conditions and the following disclaimer in the
+          documentation and/or other materials provided with the distribution.
+        - Neither the name "fawesome" or "FawesomeEngine" nor the names of its contributors
+          may be used to endorse or promote products derived from this software
+          without specific prior written permission.
+
+        THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+        "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+        LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+        PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL MARKUS WAGNER BE
+        LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+        CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+        SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+        INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+        CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+        ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+        THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef MUSICSTREAM_H
+#define MUSICSTREAM_H
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include <SDL/SDL_thread.h>
+#include <SDL/SDL_mutex.h>
+
+
+class wav_decoder;
+
+/**
+ * Background music decoded a little at a time by a worker thread into a ring buffer the mixer reads from.
+ * Only a few kilobytes of a track are ever read ahead, looping continues straight from the end into the start,
+ * and a new track fades in while the old one fades out. Changes are heard once the buffered audio has played.
+ * The game thread never touches the file, it only leaves a request for the worker.
+ */
+class music_stream {
+private:
+    static const uint32_t RING_FRAMES = 16384; // Power of two, about 0.37 s at 44.1 kHz
+    static const uint32_t CHUNK_FRAMES = 1024;
+
+    int16_t ring[RING_FRAMES * 2];
+    volatile uint32_t read_position; // In frames, written by the audio thread
+    volatile uint32_t write_position; // Written by the worker
+
+    uint32_t m_rate;
+
+    SDL_Thread* worker;
+    SDL_mutex* mutex;
+    SDL_cond* wake;
+
+    // Left by the game thread for the worker, under mutex
+    bool request_pending;
+    std::string request_file;
+    uint32_t request_fade;
+    bool request_loop;
+    bool quit;
+
+    // The worker's own
+    wav_decoder* playing;
+    wav_decoder* fading;
+    uint32_t fade_frames;
+    uint32_t fade_position;
+    std::vector<int16_t> incoming;
+    std::vector<int16_t> outgoing;
+
+    static int work(void* data);
+
+    void take_request();
+    void produce();
+public:
+    /**
+     * @param rate
+     * 	The device rate in Hz, the output is always stereo.
+     */
+    music_stream(uint32_t rate);
+    ~music_stream();
+
+    /**
+     * Switches to another WAV file, crossfading over fade milliseconds. An empty name fades out to silence.
+     */
+    void play(const std::string& file, uint32_t fade, bool loop);
+
+    /**
+     * Audio thread side: adds up to frames of music to mixed, scaled by volume from 0 to 256.
+     * Missing frames are left silent.
+     */
+    void mix(int32_t* mixed, uint32_t frames, int32_t volume);
+};
+
+#endif // MUSICSTREAM_H
@@ -0,0 +1,174 @@
+/*
+	Copyright (c) 2010, Markus Wagner (bgld)
+	All rights reserved.
+
+	Redistribution and use in source and binary forms, with or without
+	modification, are permitted provided that the following conditions are
+	met:
+	- Redistributions of source code must retain the above copyright
+	  notice, this list of conditions and the following disclaimer.
+	- Redistributions in binary form must reproduce the above copyright
+	  notice, this list of conditions and the following disclaimer in the
+	  documentation and/or other materials provided with the distribution.
+	- Neither the name "fawesome" or "FawesomeEngine" nor the names of its contributors
+	  may be used to endorse or promote products derived from this software
+	  without specific prior written permission.
+
+	THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+	"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+	LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+	PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL MARKUS WAGNER BE
+	LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+	CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+	SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+	INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+	CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+	ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+	THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "pixelcache.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#ifdef WIN32
+#        include <io.h>
+#endif
+
+#include "archive.h"
+
+pixel_cache::pixel_cache(const std::string& directory) {
+	m_directory = directory;
+
+	if(!m_directory.empty() && m_directory[m_directory.size() - 1] != '/')
+		m_directory.push_back('/');
+
+#ifdef WIN32
+	mkdir(m_directory.c_str());
+#else
+	mkdir(m_directory.c_str(), 0755);
+#endif
+}
+
+std::string pixel_cache::entry_file(const std::string& name) const {
+	char hex[9];
+	sprintf(hex, "%08x", asset_archive::hash(name));
+
+	return m_directory + hex + ".fpc";
+}
+
+void pixel_cache::fill_header(header& head, const std::string& name, time_t mtime) const {
+	SDL_Surface* display = SDL_GetVideoSurface();
+
+	memset(&head, 0, sizeof(head));
+
+	head.magic = MAGIC;
+	head.version = VERSION;
+	head.mtime = mtime;
+
+	if(display != NULL) {
+		head.display_bpp = display->format->BitsPerPixel;
+		head.display_rmask = display->format->Rmask;
+		head.display_gmask = display->format->Gmask;
+		head.display_bmask = display->format->Bmask;
+	}
+
+	head.name_length = name.size();
+}
+
+SDL_Surface* pixel_cache::load(const std::string& name, time_t mtime) const {
+	FILE* handle = fopen(entry_file(name).c_str(), "rb");
+
+	if(handle == NULL)
+		return NULL;
+
+	header expected;
+	fill_header(expected, name, mtime);
+
+	header head;
+	std::string stored_name(name.size(), '\0');
+
+	SDL_Surface* surface = NULL;
+
+	if(
+		fread(&head, sizeof(head), 1, handle) == 1 &&
+		head.magic == expected.magic &&
+		head.version == expected.version &&
+		head.mtime == expected.mtime &&
+		head.display_bpp == expected.display_bpp &&
+		head.display_rmask == expected.display_rmask &&
+		head.display_gmask == expected.display_gmask &&
+		head.display_bmask == expected.display_bmask &&
+		head.name_length == expected.name_length &&
+		fread(&stored_name[0], 1, name.size(), handle) == name.size() &&
+		stored_name == name // Guard against hash collisions
+	) {
+		surface = SDL_CreateRGBSurface(
+			SDL_SWSURFACE | (head.amask ? SDL_SRCALPHA : 0),
+			head.width,
+			head.height,
+			head.bpp,
+
+			head.rmask,
+			head.gmask,
+			head.bmask,
+			head.amask
+		);
+
+		// One read straight into the surface
+
+		if(surface != NULL && (surface->pitch != head.pitch || fread(surface->pixels, head.pitch, head.height, handle) != head.height)) {
+			SDL_FreeSurface(surface);
+			surface = NULL;
+		}
+	}
+
+	fclose(handle);
+
+	return surface;
+}
+
+void pixel_cache::store(const std::string& name, time_t mtime, SDL_Surface* surface) const {
+	FILE* handle = fopen(entry_file(name).c_str(), "wb");
+
+	if(handle == NULL)
+		return; // Read-only installation, just keep decoding
+
+	header head;
+	fill_header(head, name, mtime);
+
+	head.width = surface->w;
+	head.height = surface->h;
+	head.pitch = surface->pitch;
+	head.bpp = surface->format->BitsPerPixel;
+	head.rmask = surface->format->Rmask;
+	head.gmask = surface->format->Gmask;
+	head.bmask = surface->format->Bmask;
+	head.amask = surface->format->Amask;
+
+	SDL_LockSurface(surface);
+
+	bool written =
+		fwrite(&head, sizeof(head), 1, handle) == 1 &&
+		fwrite(name.data(), 1, name.size(), handle) == name.size() &&
+		fwrite(surface->pixels, surface->pitch, surface->h, handle) == (size_t)surface->h;
+
+	SDL_UnlockSurface(surface);
+
+	fclose(handle);
+
+	if(!written)
+		remove(entry_file(name).c_str());
+}
+
+time_t pixel_cache::modified(const std::string& file) {
+	struct stat info;
+
+	if(stat(file.c_str(), &info) != 0)
+		return 0;
+
+	return info.st_mtime;
+}
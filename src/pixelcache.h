@@ -0,0 +1,100 @@
+/*
+        Copyright (c) 2010, Markus Wagner (bgld)
+        All rights reserved.
+
+        Redistribution and use in source and binary forms, with or without
+        modification, are permitted provided that the following conditions are
+        met:
+        - Redistributions of source code must retain the above copyright
+          notice, this list of conditions and the following disclaimer.
+        - Redistributions in binary form must reproduce the above copyright
+          notice, this list of conditions and the following disclaimer in the
+          documentation and/or other materials provided with the distribution.
+        - Neither the name "fawesome" or "FawesomeEngine" nor the names of its contributors
+          may be used to endorse or promote products derived from this software
+          without specific prior written permission.
+
+        THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+        "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+        LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+        PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL MARKUS WAGNER BE
+        LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+        CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+        SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+        INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+        CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+        ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+        THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef PIXELCACHE_H
+#define PIXELCACHE_H
+
+#include <string>
+#include <stdint.h>
+#include <time.h>
+#include <SDL/SDL.h>
+
+
+/**
+ * On-disk cache of decoded images in display format, one file per image.
+ * An entry is only used if the source modification time and the display pixel format still match,
+ * so PNG decoding is paid once per asset change instead of on every start.
+ */
+class pixel_cache {
+private:
+    struct header {
+        uint32_t magic;
+        uint32_t version;
+
+        uint32_t mtime;
+
+        // Video surface format the pixels were converted for
+
+        uint32_t display_bpp;
+        uint32_t display_rmask, display_gmask, display_bmask;
+
+        // Format of the stored pixels
+
+        uint32_t width, height, pitch, bpp;
+        uint32_t rmask, gmask, bmask, amask;
+
+        uint32_t name_length;
+    };
+
+    std::string m_directory;
+
+    std::string entry_file(const std::string& name) const;
+    void fill_header(header& head, const std::string& name, time_t mtime) const;
+public:
+    static const uint32_t MAGIC = 0x43504146; // "FAPC"
+    static const uint32_t VERSION = 1;
+
+    /**
+     * @param directory
+     * 	Where the cache files are kept, created if missing.
+     */
+    pixel_cache(const std::string& directory);
+
+    /**
+     * Loads a cached image.
+     *
+     * @param name
+     * 	The image file the entry was stored for.
+     * @param mtime
+     * 	The current modification time of the source.
+     * @return
+     * 	A new surface or NULL if there is no valid entry.
+     */
+    SDL_Surface* load(const std::string& name, time_t mtime) const;
+
+    void store(const std::string& name, time_t mtime, SDL_Surface* surface) const;
+
+    /**
+     * @return
+     * 	The modification time of a file or 0 if it doesn't exist.
+     */
+    static time_t modified(const std::string& file);
+};
+
+#endif // PIXELCACHE_H
@@ -0,0 +1,241 @@
+/*
+	Copyright (c) 2010, Markus Wagner (bgld)
+	All rights reserved.
+
+	Redistribution and use in source and binary forms, with or without
+	modification, are permitted provided that the following conditions are
+	met:
+	- Redistributions of source code must retain the above copyright
+	  notice, this list of conditions and the following disclaimer.
+	- Redistributions in binary form must reproduce the above copyright
+	  notice, this list of conditions and the following disclaimer in the
+	  documentation and/or other materials provided with the distribution.
+	- Neither the name "fawesome" or "FawesomeEngine" nor the names of its contributors
+	  may be used to endorse or promote products derived from this software
+	  without specific prior written permission.
+
+	THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+	"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+	LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+	PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL MARKUS WAGNER BE
+	LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+	CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+	SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+	INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+	CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+	ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+	THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "profiler.h"
+
+#include <fstream>
+#include <string.h>
+#include <algorithm>
+
+#ifdef WIN32
+#        include <windows.h>
+#else
+#        include <time.h>
+#endif
+
+#include "constants.h"
+
+#define PROFILE_GRAPH_SCALE 250 // Microseconds per pixel
+
+const uint16_t profiler::FRAMES;
+const uint32_t profiler::EVENTS;
+
+bool profiler::m_enabled = false;
+bool profiler::m_graph = false;
+
+uint32_t profiler::durations[FRAMES][PHASE_COUNT];
+uint16_t profiler::current_frame = 0;
+uint32_t profiler::frames_seen = 0;
+
+std::vector<profiler::trace_event> profiler::trace;
+uint32_t profiler::next_event = 0;
+uint64_t profiler::epoch = 0;
+
+const char* profiler::names[PHASE_COUNT] = {
+	"events",
+	"script",
+	"calculate",
+	"sort",
+	"display",
+	"text",
+	"zoom",
+	"flip"
+};
+
+void profiler::init(bool enabled, bool graph) {
+	m_enabled = enabled;
+	m_graph = enabled && graph;
+
+	memset(durations, 0, sizeof(durations));
+	current_frame = 0;
+	frames_seen = 0;
+
+	if(m_enabled)
+		trace.resize(EVENTS);
+
+	next_event = 0;
+	epoch = now();
+}
+
+bool profiler::enabled() {
+	return m_enabled;
+}
+
+bool profiler::graph() {
+	return m_graph;
+}
+
+void profiler::graph(bool graph) {
+	m_graph = m_enabled && graph;
+}
+
+uint64_t profiler::now() {
+#ifdef WIN32
+	LARGE_INTEGER frequency;
+	LARGE_INTEGER counter;
+
+	QueryPerformanceFrequency(&frequency);
+	QueryPerformanceCounter(&counter);
+
+	return (uint64_t)counter.QuadPart * 1000000 / frequency.QuadPart;
+#else
+	timespec time;
+	clock_gettime(CLOCK_MONOTONIC, &time);
+
+	return (uint64_t)time.tv_sec * 1000000 + time.tv_nsec / 1000;
+#endif
+}
+
+void profiler::frame() {
+	if(!m_enabled)
+		return;
+
+	current_frame = (current_frame + 1) % FRAMES;
+	memset(durations[current_frame], 0, sizeof(durations[current_frame]));
+
+	if(frames_seen < FRAMES)
+		frames_seen++;
+}
+
+void profiler::record(phase phase, uint64_t start, uint64_t end) {
+	uint32_t duration = end - start;
+
+	durations[current_frame][phase] += duration;
+
+	trace_event& event = trace[next_event % EVENTS];
+	event.start = start;
+	event.duration = duration;
+	event.phase = phase;
+
+	next_event++;
+}
+
+const char* profiler::name(phase phase) {
+	return names[phase];
+}
+
+uint32_t profiler::average(phase phase) {
+	uint16_t completed = finished_frames();
+
+	if(completed == 0)
+		return 0;
+
+	uint64_t sum = 0;
+
+	for(uint16_t i = 1; i <= completed; i++)
+		sum += durations[(current_frame + FRAMES - i) % FRAMES][phase];
+
+	return sum / completed;
+}
+
+uint32_t profiler::maximum(phase phase) {
+	uint16_t completed = finished_frames();
+	uint32_t result = 0;
+
+	for(uint16_t i = 1; i <= completed; i++)
+		result = std::max(result, durations[(current_frame + FRAMES - i) % FRAMES][phase]);
+
+	return result;
+}
+
+uint16_t profiler::finished_frames() {
+	// The current frame is still being recorded
+
+	return frames_seen > 0 ? frames_seen - 1 : 0;
+}
+
+void profiler::draw(SDL_Surface* target) {
+	if(!m_graph)
+		return;
+
+	static const uint8_t colors[PHASE_COUNT][3] = {
+		{ 0x80, 0x80, 0x80 },
+		{ 0xe0, 0x40, 0x40 },
+		{ 0x40, 0xa0, 0xe0 },
+		{ 0x40, 0xe0, 0xe0 },
+		{ 0x40, 0xe0, 0x40 },
+		{ 0xe0, 0xe0, 0x40 },
+		{ 0xe0, 0x40, 0xe0 },
+		{ 0xff, 0xff, 0xff }
+	};
+
+	// Text is already part of display, stacking it again would count it twice
+
+	uint16_t budget = 1000000 / HARD_FPS_LIMIT / PROFILE_GRAPH_SCALE;
+	uint16_t columns = target->w < FRAMES ? target->w : FRAMES;
+
+	for(uint16_t column = 0; column < columns; column++) {
+		uint16_t frame = (current_frame + 1 + FRAMES - columns + column) % FRAMES;
+		int32_t bottom = target->h;
+
+		for(uint8_t phase = 0; phase < PHASE_COUNT; phase++) {
+			if(phase == PHASE_TEXT)
+				continue;
+
+			int32_t height = durations[frame][phase] / PROFILE_GRAPH_SCALE;
+
+			if(height <= 0 || bottom <= 0)
+				continue;
+
+			height = std::min(height, bottom);
+			bottom -= height;
+
+			SDL_Rect bar = { (Sint16)column, (Sint16)bottom, 1, (Uint16)height };
+			SDL_FillRect(target, &bar, SDL_MapRGB(target->format, colors[phase][0], colors[phase][1], colors[phase][2]));
+		}
+	}
+
+	SDL_Rect line = { 0, (Sint16)(target->h - budget), columns, 1 };
+	SDL_FillRect(target, &line, SDL_MapRGB(target->format, 0xff, 0x00, 0x00));
+}
+
+void profiler::dump(const std::string& file_name) {
+	if(!m_enabled || next_event == 0)
+		return;
+
+	std::ofstream stream(file_name.c_str());
+
+	if(!stream.good())
+		return;
+
+	uint32_t first = next_event > EVENTS ? next_event - EVENTS : 0;
+
+	stream << "{\"traceEvents\":[" << std::endl;
+
+	for(uint32_t i = first; i < next_event; i++) {
+		const trace_event& event = trace[i % EVENTS];
+
+		stream
+			<< "{\"name\":\"" << names[event.phase] << "\",\"ph\":\"X\",\"pid\":1,\"tid\":1,"
+			<< "\"ts\":" << (event.start - epoch) << ",\"dur\":" << event.duration << "}"
+			<< (i + 1 < next_event ? "," : "") << std::endl;
+	}
+
+	stream << "]}" << std::endl;
+}
@@ -0,0 +1,145 @@
+/*
+        Copyright (c) 2010, Markus Wagner (bgld)
+        All rights reserved.
+
+        Redistribution and use in source and binary forms, with or without
+        modification, are permitted provided that the following conditions are
+        met:
+        - Redistributions of source code must retain the above copyright
+          notice, this list of conditions and the following disclaimer.
+        - Redistributions in binary form must reproduce the above copyright
+          notice, this list of conditions and the following disclaimer in the
+          documentation and/or other materials provided with the distribution.
+        - Neither the name "fawesome" or "FawesomeEngine" nor the names of its contributors
+          may be used to endorse or promote products derived from this software
+          without specific prior written permission.
+
+        THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+        "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+        LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+        PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL MARKUS WAGNER BE
+        LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+        CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+        SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+        INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+        CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+        ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+        THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <vector>
+#include <string>
+#include <stdint.h>
+#include <SDL/SDL.h>
+
+
+/**
+ * Frame profiler with fixed phases, timed by profile_scope objects placed around the work.
+ * The last FRAMES frames are kept per phase for the summary and the on-screen graph,
+ * the last EVENTS scopes with their start times for a Chrome trace (chrome://tracing) written on exit.
+ * Phases nest, e.g. text rendering is also counted in sprite display.
+ * Everything is preallocated, disabled it costs one branch per scope.
+ */
+class profiler {
+public:
+    enum phase {
+        PHASE_EVENTS = 0,
+        PHASE_SCRIPT,
+        PHASE_CALCULATE,
+        PHASE_SORT,
+        PHASE_DISPLAY,
+        PHASE_TEXT,
+        PHASE_ZOOM,
+        PHASE_FLIP,
+
+        PHASE_COUNT
+    };
+
+    static const uint16_t FRAMES = 256;
+    static const uint32_t EVENTS = 65536;
+private:
+    struct trace_event {
+        uint64_t start;
+        uint32_t duration;
+        uint8_t phase;
+    };
+
+    static bool m_enabled;
+    static bool m_graph;
+
+    static uint32_t durations[FRAMES][PHASE_COUNT]; // In microseconds
+    static uint16_t current_frame;
+    static uint32_t frames_seen;
+
+    static std::vector<trace_event> trace;
+    static uint32_t next_event;
+    static uint64_t epoch;
+
+    static const char* names[PHASE_COUNT];
+
+    /**
+     * Frames in the ring before the current one.
+     */
+    static uint16_t finished_frames();
+public:
+    static void init(bool enabled, bool graph);
+
+    static bool enabled();
+    static bool graph();
+    static void graph(bool graph);
+
+    /**
+     * Monotonic time in microseconds.
+     */
+    static uint64_t now();
+
+    /**
+     * Starts a new frame in the ring, call once at the top of the main loop.
+     */
+    static void frame();
+
+    static void record(phase phase, uint64_t start, uint64_t end);
+
+    static const char* name(phase phase);
+
+    /**
+     * Average and maximum time per frame over the finished frames in the ring, in microseconds.
+     */
+    static uint32_t average(phase phase);
+    static uint32_t maximum(phase phase);
+
+    /**
+     * Draws one stacked bar per frame in the ring into the bottom left corner of target,
+     * with a line at the frame budget.
+     */
+    static void draw(SDL_Surface* target);
+
+    /**
+     * Writes the trace ring as Chrome trace event JSON.
+     */
+    static void dump(const std::string& file_name);
+};
+
+/**
+ * Times its own lifetime into a profiler phase.
+ */
+class profile_scope {
+private:
+    profiler::phase m_phase;
+    uint64_t start;
+public:
+    profile_scope(profiler::phase phase) {
+        m_phase = phase;
+        start = profiler::enabled() ? profiler::now() : 0;
+    }
+
+    ~profile_scope() {
+        if(profiler::enabled())
+            profiler::record(m_phase, start, profiler::now());
+    }
+};
+
+#endif // PROFILER_H
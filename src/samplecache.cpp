@@ -0,0 +1,211 @@
+/*
+	Copyright (c) 2010, Markus Wagner (bgld)
+	All rights reserved.
+
+	Redistribution and use in source and binary forms, with or without
+	modification, are permitted provided that the following conditions are
+	met:
+	- Redistributions of source code must retain the above copyright
+	  notice, this list of conditions and the following disclaimer.
+	- Redistributions in binary form must reproduce the above copyright
+	  notice, this list of conditions and the following disclaimer in the
+	  documentation and/or other materials provided with the distribution.
+	- Neither the name "fawesome" or "FawesomeEngine" nor the names of its contributors
+	  may be used to endorse or promote products derived from this software
+	  without specific prior written permission.
+
+	THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+	"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+	LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+	PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL MARKUS WAGNER BE
+	LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+	CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+	SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+	INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+	CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+	ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+	THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "samplecache.h"
+
+#include <string.h>
+#include <stdexcept>
+#include <SDL/SDL.h>
+
+#include "filenotfoundexception.h"
+#include "file.h"
+
+sample_cache::sample_cache(uint32_t budget, const SDL_AudioSpec& spec) {
+	m_budget = budget;
+	m_bytes = 0;
+
+	m_hits = 0;
+	m_misses = 0;
+	m_evictions = 0;
+
+	m_spec = spec;
+}
+
+sample_cache::~sample_cache() {
+	for(
+		sample_map::iterator iter = samples.begin();
+		iter != samples.end();
+		iter++
+	) {
+		sample* pcm = (*iter).second.pcm;
+
+		delete[] (uint8_t*)pcm->data;
+		delete pcm;
+	}
+}
+
+const sample* sample_cache::fetch(const std::string& name) {
+	std::string file_name = file(name);
+
+	sample_map::iterator result = samples.find(file_name);
+
+	if(result != samples.end()) {
+		m_hits++;
+
+		(*result).second.refs++;
+		touch((*result).second, file_name);
+
+		return (*result).second.pcm;
+	}
+
+	m_misses++;
+
+	sample_entry entry;
+	entry.pcm = load(file_name);
+	entry.refs = 1;
+	entry.bytes = entry.pcm->length * sizeof(int16_t);
+	entry.lru = lru.insert(lru.begin(), file_name);
+
+	samples.insert(std::make_pair(file_name, entry));
+	owners.insert(std::make_pair(entry.pcm, file_name));
+
+	m_bytes += entry.bytes;
+
+	evict();
+
+	return entry.pcm;
+}
+
+sample* sample_cache::load(const std::string& file_name) const {
+	SDL_AudioSpec wav;
+	uint8_t* buffer;
+	uint32_t length;
+
+	if(SDL_LoadWAV(file_name.c_str(), &wav, &buffer, &length) == NULL)
+		throw file_not_found_exception(file_name);
+
+	// Convert to the device format once, so mixing is only adding up
+
+	SDL_AudioCVT cvt;
+
+	if(SDL_BuildAudioCVT(&cvt, wav.format, wav.channels, wav.freq, m_spec.format, m_spec.channels, m_spec.freq) < 0) {
+		SDL_FreeWAV(buffer);
+		throw std::runtime_error("Can't convert " + file_name + " to the audio device format");
+	}
+
+	cvt.len = length;
+	cvt.buf = new uint8_t[length * cvt.len_mult + sizeof(int16_t)];
+
+	memcpy(cvt.buf, buffer, length);
+	SDL_FreeWAV(buffer);
+
+	SDL_ConvertAudio(&cvt);
+
+	if(cvt.len_cvt < (int)sizeof(int16_t)) {
+		delete[] cvt.buf;
+		throw std::runtime_error(file_name + " holds no audio");
+	}
+
+	sample* pcm = new sample;
+	pcm->data = (int16_t*)cvt.buf;
+	pcm->length = cvt.len_cvt / sizeof(int16_t);
+
+	return pcm;
+}
+
+void sample_cache::release(const sample* pcm) {
+	sample_owner_map::iterator owner = owners.find(pcm);
+
+	if(owner == owners.end())
+		return;
+
+	sample_entry& entry = samples[(*owner).second];
+
+	if(entry.refs > 0)
+		entry.refs--;
+
+	if(entry.refs == 0)
+		evict();
+}
+
+void sample_cache::preload(const std::string& file) {
+	release(fetch(file));
+}
+
+void sample_cache::touch(sample_entry& entry, const std::string& file_name) {
+	lru.erase(entry.lru);
+	entry.lru = lru.insert(lru.begin(), file_name);
+}
+
+void sample_cache::evict() {
+	std::list<std::string>::iterator iter = lru.end();
+
+	// Samples still playing are referenced and never freed, so the budget is a soft limit
+
+	while(m_bytes > m_budget && iter != lru.begin()) {
+		iter--;
+
+		sample_map::iterator result = samples.find(*iter);
+		sample_entry& entry = (*result).second;
+
+		if(entry.refs > 0)
+			continue;
+
+		m_bytes -= entry.bytes;
+		m_evictions++;
+
+		owners.erase(entry.pcm);
+
+		delete[] (uint8_t*)entry.pcm->data;
+		delete entry.pcm;
+
+		iter = lru.erase(iter);
+		samples.erase(result);
+	}
+}
+
+uint32_t sample_cache::budget() const {
+	return m_budget;
+}
+
+void sample_cache::budget(uint32_t budget) {
+	m_budget = budget;
+
+	evict();
+}
+
+uint32_t sample_cache::hits() const {
+	return m_hits;
+}
+
+uint32_t sample_cache::misses() const {
+	return m_misses;
+}
+
+uint32_t sample_cache::evictions() const {
+	return m_evictions;
+}
+
+uint32_t sample_cache::bytes() const {
+	return m_bytes;
+}
+
+uint32_t sample_cache::count() const {
+	return samples.size();
+}
@@ -0,0 +1,118 @@
+/*
+        Copyright (c) 2010, Markus Wagner (bgld)
+        All rights reserved.
+
+        Redistribution and use in source and binary forms, with or without
+        modification, are permitted provided that the following conditions are
+        met:
+        - Redistributions of source code must retain the above copyright
+          notice, this list of conditions and the following disclaimer.
+        - Redistributions in binary form must reproduce the above copyright
+          notice, this list of conditions and the following disclaimer in the
+          documentation and/or other materials provided with the distribution.
+        - Neither the name "fawesome" or "FawesomeEngine" nor the names of its contributors
+          may be used to endorse or promote products derived from this software
+          without specific prior written permission.
+
+        THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+        "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+        LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+        PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL MARKUS WAGNER BE
+        LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+        CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+        SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+        INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+        CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+        ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+        THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef SAMPLECACHE_H
+#define SAMPLECACHE_H
+
+#include <map>
+#include <list>
+#include <string>
+#include <stdint.h>
+#include <SDL/SDL_audio.h>
+
+
+/**
+ * Decoded PCM in the device format, interleaved.
+ */
+struct sample {
+    int16_t* data;
+    uint32_t length; // In values, not frames
+};
+
+struct sample_entry {
+    sample* pcm;
+
+    uint32_t refs;
+    uint32_t bytes;
+
+    std::list<std::string>::iterator lru;
+};
+
+typedef std::map<std::string, sample_entry> sample_map;
+typedef std::map<const sample*, std::string> sample_owner_map;
+
+/**
+ * Loads sound effects once, already converted to the device format, and hands out shared buffers.
+ * Every voice playing a sample holds a reference, so any number of them can read the same buffer.
+ * Unreferenced samples stay resident until the byte budget is exceeded and are then evicted least recently used first.
+ */
+class sample_cache {
+private:
+    sample_map samples;
+    sample_owner_map owners;
+
+    std::list<std::string> lru; // Front is the most recently used entry
+
+    uint32_t m_budget;
+    uint32_t m_bytes;
+
+    uint32_t m_hits, m_misses, m_evictions;
+
+    SDL_AudioSpec m_spec;
+
+    sample* load(const std::string& file_name) const;
+
+    void touch(sample_entry& entry, const std::string& file_name);
+    void evict();
+public:
+    /**
+     * @param budget
+     * 	Total bytes the cache aims to stay under. Referenced samples are never evicted, so this is a soft limit.
+     * @param spec
+     * 	The format of the audio device, samples are converted to it on load.
+     */
+    sample_cache(uint32_t budget, const SDL_AudioSpec& spec);
+    ~sample_cache();
+
+    /**
+     * Returns the decoded WAV file and adds a reference to it. Every fetch has to be paired with a release.
+     */
+    const sample* fetch(const std::string& file);
+
+    /**
+     * Drops a reference obtained by fetch.
+     */
+    void release(const sample* pcm);
+
+    /**
+     * Loads a file ahead of its first use without keeping a reference, so it stays as long as the budget allows.
+     */
+    void preload(const std::string& file);
+
+    uint32_t budget() const;
+    void budget(uint32_t budget);
+
+    uint32_t hits() const;
+    uint32_t misses() const;
+    uint32_t evictions() const;
+    uint32_t bytes() const;
+    uint32_t count() const;
+};
+
+#endif // SAMPLECACHE_H
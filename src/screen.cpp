@@ -31,17 +31,53 @@
 
 #include <iostream>
 #include <algorithm>
-
-#include <SDL/SDL_rotozoom.h>
+#include <math.h>
 
 #include "events/activateevent.h"
 #include "constants.h"
 #include "file.h"
+#include "allocations.h"
+#include "profiler.h"
 
 screen::screen(event_queue* queue) {
 	m_queue = queue;
 
-	m_cache = new surface_cache();
+	m_scene = new scene_graph();
+	gfx_object::graph(m_scene);
+
+	atlas* sheets = NULL;
+
+	if(config->bool_value("atlas"))
+		sheets = new atlas(config->int_value("atlas_size"), config->int_value("atlas_image_size"));
+
+	asset_archive* archive = NULL;
+
+	if(config->value("archive") != "") {
+		try {
+			archive = new asset_archive(file(config->value("archive")));
+		} catch(file_not_found_exception e) {
+			archive = NULL; // Loose files only
+		} catch(std::runtime_error e) {
+			exception_message(e, "\nRebuild it with fawpack or delete it.");
+		}
+	}
+
+	pixel_cache* pixels = NULL;
+
+	if(config->value("pixel_cache") != "")
+		pixels = new pixel_cache(file(config->value("pixel_cache")));
+
+	m_cache = new surface_cache(config->int_value("cache_budget") * 1024 * 1024, sheets, archive, pixels);
+
+	m_templates = new animation_registry(m_cache);
+	sprite::registry(m_templates);
+
+	blitter::init(config->int_value("worker_threads"));
+
+	m_arena = new frame_arena(config->int_value("frame_arena") * 1024);
+	m_frame_allocations = 0;
+
+	sprite::stats(&m_counters);
 
 	// Screen setup
 
@@ -63,7 +99,7 @@ screen::screen(event_queue* queue) {
 		error_message("Could not set video mode!");
 
 	background = SDL_CreateRGBSurface(
-		SDL_SWSURFACE | SDL_SRCALPHA | SDL_RLEACCEL,
+		SDL_SWSURFACE | SDL_SRCALPHA,
 		config->int_value("display_width"),
 		config->int_value("display_height"),
 		config->int_value("screen_bpp"),
@@ -75,7 +111,6 @@ screen::screen(event_queue* queue) {
 	);
 
 	temp_screen = SDL_DisplayFormat(background);
-	zoomed_screen = NULL;
 
 	// Rect for letterboxing
 
@@ -84,8 +119,9 @@ screen::screen(event_queue* queue) {
 	display_rect.x = (config->int_value("screen_width") - (config->int_value("display_width") * config->int_value("screen_zoom"))) / 2;
 	display_rect.y = (config->int_value("screen_height") - (config->int_value("display_height") * config->int_value("screen_zoom"))) / 2;
 
-	tint_surface = SDL_DisplayFormat(background);
-	SDL_SetAlpha(tint_surface, SDL_SRCALPHA, 0);
+	tint(0, 0, 0, 0, 256, 256, 256);
+
+	m_overlay = new screen_overlay(m_cache, temp_screen->format);
 
 	// FPS
 
@@ -115,14 +151,24 @@ screen::~screen() {
 		delete (*iter);
 	}
 
+	gfx_object::graph(NULL);
+	delete m_scene;
+
+	sprite::registry(NULL);
+	delete m_templates;
+
+	delete m_overlay;
+
 	SDL_FreeSurface(screen_surface);
 	SDL_FreeSurface(background);
 	SDL_FreeSurface(temp_screen);
-	SDL_FreeSurface(zoomed_screen);
-	SDL_FreeSurface(tint_surface);
+
+	blitter::quit();
 
 	delete limiter;
 
+	delete m_arena;
+
 	delete m_cache;
 
 	free(fps_font);
@@ -144,39 +190,67 @@ void screen::deserialize(std::istream& stream) {
 }
 
 void screen::display() {
+	uint32_t allocations = allocation_count();
+
 	bool new_fps = limiter->new_fps();
 	bool flip = false;
 
-	// Calculate coordinates
+	// Calculate coordinates, sleeping sprites have nothing to calculate
 
-	std::vector<sprite_container::iterator> updated_sprites;
+	typedef std::vector<sprite*, arena_allocator<sprite*> > sprite_list;
 
-	for(
-		sprite_container::iterator iter = sprites.begin();
-		iter != sprites.end();
-		iter++
-	) {
-		(*iter)->calculate();
+	sprite_list updated_sprites((arena_allocator<sprite*>(m_arena)));
+
+	{
+		profile_scope scope(profiler::PHASE_CALCULATE);
+
+		m_scene->time(SDL_GetTicks());
+		m_scene->simulate();
+
+		const std::vector<uint32_t>& awake = m_scene->awake();
+
+		for(uint32_t i = 0; i < awake.size(); i++) { // calculate() may wake others, they get their turn too
+			uint32_t node = awake[i];
+
+			if(node < placement.size() && placement[node] != sprites.end())
+				(*placement[node])->calculate();
+		}
+
+		m_scene->update();
 
-		if((*iter)->coords_updated())
-			updated_sprites.push_back(iter);
+		// Moved by a setter or simulate() shows up among the awake ones, moved along with a parent only in moved()
+
+		collect_updated(awake, updated_sprites);
+		collect_updated(m_scene->moved(), updated_sprites);
 	}
 
-	// Reinsert all elements that changed
+	// Reinsert all elements that changed, all of them are taken out first so no stale key is compared against
 
-	for(
-		std::vector<sprite_container::iterator>::iterator iter = updated_sprites.begin();
-		iter != updated_sprites.end();
-		iter++
-	) {
-		sprite* tmp = **iter;
-		sprites.erase(*iter);
-		sprites.insert(tmp);
+	{
+		profile_scope scope(profiler::PHASE_SORT);
+
+		for(
+			sprite_list::iterator iter = updated_sprites.begin();
+			iter != updated_sprites.end();
+			iter++
+		) {
+			sprites.erase(placement[(*iter)->node()]);
+		}
+
+		for(
+			sprite_list::iterator iter = updated_sprites.begin();
+			iter != updated_sprites.end();
+			iter++
+		) {
+			push(*iter);
+		}
 	}
 
 	// Display all sprites if we are not frameskipping
 
 	if(!do_frameskip || frameskip >= MAX_FRAMESKIP || limiter->fps() >= FPS_TOLERANCE_FACTOR * limiter->fps_limit()) {
+		profile_scope scope(profiler::PHASE_DISPLAY);
+
 		for(
 			sprite_container::iterator iter = sprites.begin();
 			iter != sprites.end();
@@ -194,8 +268,13 @@ void screen::display() {
 	}
 
 	if(new_fps) {
+		profile_scope scope(profiler::PHASE_TEXT);
+
 		fps_stream.str("");
 		fps_stream << limiter->fps() << " FPS";
+#ifdef DEBUG
+		fps_stream << ", " << m_frame_allocations << " allocations";
+#endif
 
 		SDL_FreeSurface(fps_text);
 		fps_text = TTF_RenderText_Blended(fps_font, fps_stream.str().c_str(), fps_color);
@@ -209,18 +288,71 @@ void screen::display() {
 	};
 
 	SDL_BlitSurface(fps_text, NULL, temp_screen, &fps_rect);
+	m_counters.blit(fps_rect);
+
+	profiler::draw(temp_screen);
 
-	SDL_BlitSurface(tint_surface, NULL, temp_screen, NULL);
+	// Scale straight into the video surface instead of going through a new zoomed copy every frame, overlay, tint and gamma come along
 
-	SDL_FreeSurface(zoomed_screen);
-	zoomed_screen = zoomSurface(temp_screen, config->int_value("screen_zoom"), config->int_value("screen_zoom"), 0);
-	SDL_BlitSurface(zoomed_screen, NULL, screen_surface, &display_rect);
+	{
+		profile_scope scope(profiler::PHASE_ZOOM);
+
+		blitter::zoom(temp_screen, screen_surface, &display_rect, config->int_value("screen_zoom"), tint_identity ? NULL : &tint_table, m_overlay->layer());
+
+		m_counters.blits++;
+		m_counters.pixels += temp_screen->w * temp_screen->h * config->int_value("screen_zoom") * config->int_value("screen_zoom");
+	}
 
 	if(flip) {
-		SDL_Flip(screen_surface);
+		{
+			profile_scope scope(profiler::PHASE_FLIP);
+
+			SDL_Flip(screen_surface);
+		}
 
 		limiter->sleep_till_next();
 	}
+
+	updated_sprites.clear();
+	m_arena->reset();
+
+	m_frame_allocations = allocation_count() - allocations;
+
+	m_last_counters = m_counters;
+	m_total_counters += m_counters;
+	m_counters.reset();
+}
+
+surface_cache* screen::cache() const {
+	return m_cache;
+}
+
+frame_arena* screen::arena() const {
+	return m_arena;
+}
+
+uint32_t screen::frame_allocations() const {
+	return m_frame_allocations;
+}
+
+const frame_counters& screen::counters() const {
+	return m_last_counters;
+}
+
+const frame_counters& screen::total_counters() const {
+	return m_total_counters;
+}
+
+uint32_t screen::sprite_count() const {
+	return sprites.size();
+}
+
+uint32_t screen::awake_count() const {
+	return m_scene->awake().size();
+}
+
+animation_registry* screen::templates() const {
+	return m_templates;
 }
 
 void screen::reset_frameskip() {
@@ -228,14 +360,46 @@ void screen::reset_frameskip() {
 }
 
 void screen::tint(uint8_t r, uint8_t g, uint8_t b, uint8_t a, int16_t rgamma, int16_t ggamma, int16_t bgamma) {
-	SDL_FillRect(tint_surface, NULL, SDL_MapRGB(tint_surface->format, r, g, b));
-	SDL_SetAlpha(tint_surface, SDL_SRCALPHA, a);
+	// Tint blended like an alpha blit first, gamma on top, 256 meaning 1.0
+
+	uint8_t color[3] = { r, g, b };
+	int16_t gamma[3] = { rgamma, ggamma, bgamma };
+
+	tint_identity = true;
+
+	for(uint8_t channel = 0; channel < 3; channel++) {
+		double exponent = gamma[channel] > 0 ? 256.0 / gamma[channel] : 1.0;
 
-	SDL_SetGamma(rgamma / 256.0, ggamma / 256.0, bgamma / 256.0);
+		for(uint16_t i = 0; i < 256; i++) {
+			double value = i + (color[channel] - (int16_t)i) * a / 255.0;
+
+			if(exponent != 1.0)
+				value = 255.0 * pow(value / 255.0, exponent);
+
+			tint_table.channel[channel][i] = (uint8_t)(value + 0.5);
+
+			if(tint_table.channel[channel][i] != i)
+				tint_identity = false;
+		}
+	}
+}
+
+screen_overlay* screen::overlay() const {
+	return m_overlay;
 }
 
 void screen::push(sprite* sprite) {
-	sprites.insert(sprite);
+	sprite->depth();
+	place(sprites.insert(sprite));
+}
+
+void screen::place(sprite_container::iterator iter) {
+	uint32_t node = (*iter)->node();
+
+	if(node >= placement.size())
+		placement.resize(node + 1, sprites.end());
+
+	placement[node] = iter;
 }
 
 map* screen::new_map(const std::string& file, uint16_t width, uint16_t height, tcl_bind* bind) {
@@ -48,6 +48,10 @@
 #include "framelimiter.h"
 #include "filenotfoundexception.h"
 #include "serializable.h"
+#include "blitter.h"
+#include "framearena.h"
+#include "framecounters.h"
+#include "screenoverlay.h"
 
 
 class tcl_bind;
@@ -58,18 +62,49 @@ class screen : public event_handler, public serializable {
 private:
     event_queue* m_queue;
     surface_cache* m_cache;
+    animation_registry* m_templates;
+    scene_graph* m_scene;
 
     sprite_container sprites;
+    std::vector<sprite_container::iterator> placement; // Where each node's sprite sits in sprites, sprites.end() for other nodes
+
+    void place(sprite_container::iterator iter);
+
+    /**
+     * Appends the sprites of nodes flagged as moved to updated, clearing the flag, also for nodes without a sprite.
+     */
+    template<class T>
+    void collect_updated(const std::vector<uint32_t>& nodes, T& updated) {
+        for(uint32_t i = 0; i < nodes.size(); i++) {
+            uint32_t node = nodes[i];
+
+            if(node >= placement.size() || placement[node] == sprites.end()) {
+                m_scene->state().moved[node] = 0; // Nobody else picks it up for layers
+            } else if((*placement[node])->coords_updated()) {
+                updated.push_back(*placement[node]);
+            }
+        }
+    }
 
     SDL_Surface* screen_surface;
     SDL_Surface* background;
     SDL_Surface* temp_screen;
-    SDL_Surface* zoomed_screen;
-    SDL_Surface* tint_surface;
+
+    color_table tint_table;
+    bool tint_identity;
+
+    screen_overlay* m_overlay;
 
     SDL_Rect display_rect;
 
     frame_limiter* limiter;
+
+    frame_arena* m_arena; // Reset at the end of every display()
+    uint32_t m_frame_allocations;
+
+    frame_counters m_counters; // Filled by the frame in progress
+    frame_counters m_last_counters;
+    frame_counters m_total_counters;
     bool do_frameskip;
     int16_t frameskip;
 
@@ -132,8 +167,35 @@ public:
 
     void reset_frameskip();
 
+    surface_cache* cache() const;
+    animation_registry* templates() const;
+
+    /**
+     * Scratch memory for the current frame, gone once display() returns.
+     */
+    frame_arena* arena() const;
+
+    /**
+     * Heap allocations made during the last display(), 0 once the frame loop has settled.
+     */
+    uint32_t frame_allocations() const;
+
+    /**
+     * Counters of the last display(), and summed up since the start.
+     */
+    const frame_counters& counters() const;
+    const frame_counters& total_counters() const;
+
+    uint32_t sprite_count() const;
+    uint32_t awake_count() const;
+
     void tint(uint8_t r, uint8_t g, uint8_t b, uint8_t a, int16_t rgamma, int16_t ggamma, int16_t bgamma);
 
+    /**
+     * Full-screen texture blended over the display, before tint.
+     */
+    screen_overlay* overlay() const;
+
     map* new_map(const std::string& file, uint16_t width, uint16_t height, tcl_bind* bind);
 
     layer* new_layer();
@@ -0,0 +1,201 @@
+/*
+	Copyright (c) 2010, Markus Wagner (bgld)
+	All rights reserved.
+
+	Redistribution and use in source and binary forms, with or without
+	modification, are permitted provided that the following conditions are
+	met:
+	- Redistributions of source code must retain the above copyright
+	  notice, this list of conditions and the following disclaimer.
+	- Redistributions in binary form must reproduce the above copyright
+	  notice, this list of conditions and the following disclaimer in the
+	  documentation and/or other materials provided with the distribution.
+	- Neither the name "fawesome" or "FawesomeEngine" nor the names of its contributors
+	  may be used to endorse or promote products derived from this software
+	  without specific prior written permission.
+
+	THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+	"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+	LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+	PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL MARKUS WAGNER BE
+	LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+	CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+	SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+	INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+	CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+	ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+	THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "screenoverlay.h"
+
+#include <math.h>
+#include <stdexcept>
+
+
+screen_overlay::screen_overlay(surface_cache* cache, SDL_PixelFormat* format) {
+	m_cache = cache;
+	m_format = format;
+
+	m_frame_time = 100;
+	m_start = SDL_GetTicks();
+
+	m_scroll_x = 0;
+	m_scroll_y = 0;
+
+	m_opacity_from = m_opacity_to = SDL_ALPHA_OPAQUE;
+	m_fade_start = m_start;
+	m_fade_time = 0;
+
+	m_layer.surface = NULL;
+}
+
+screen_overlay::~screen_overlay() {
+	clear();
+}
+
+static uint32_t pixel_at(SDL_Surface* surface, int32_t x, int32_t y) {
+	uint8_t* pixel = (uint8_t*)surface->pixels + y * surface->pitch + x * surface->format->BytesPerPixel;
+
+	switch(surface->format->BytesPerPixel) {
+	case 1:
+		return *pixel;
+	case 2:
+		return *(uint16_t*)pixel;
+	case 3:
+#if SDL_BYTEORDER == SDL_BIG_ENDIAN
+		return pixel[0] << 16 | pixel[1] << 8 | pixel[2];
+#else
+		return pixel[0] | pixel[1] << 8 | pixel[2] << 16;
+#endif
+	default:
+		return *(uint32_t*)pixel;
+	}
+}
+
+SDL_Surface* screen_overlay::premultiply(const surface_region& region) {
+	if(m_format->BytesPerPixel != 4)
+		throw std::runtime_error("Overlays need a 32 bit screen");
+
+	uint8_t alpha_shift = blitter::spare_shift(m_format);
+
+	SDL_Surface* frame = SDL_CreateRGBSurface(
+		SDL_SWSURFACE,
+		region.rect.w,
+		region.rect.h,
+		32,
+
+		m_format->Rmask,
+		m_format->Gmask,
+		m_format->Bmask,
+		0xffu << alpha_shift
+	);
+
+	if(frame == NULL)
+		throw std::runtime_error("Couldn't create overlay frame");
+
+	SDL_Surface* source = region.surface;
+	SDL_PixelFormat* format = source->format;
+	bool keyed = (source->flags & SDL_SRCCOLORKEY) != 0;
+
+	SDL_LockSurface(source);
+	SDL_LockSurface(frame);
+
+	for(int32_t y = 0; y < region.rect.h; y++) {
+		uint32_t* out = (uint32_t*)((uint8_t*)frame->pixels + y * frame->pitch);
+
+		for(int32_t x = 0; x < region.rect.w; x++) {
+			uint32_t value = pixel_at(source, region.rect.x + x, region.rect.y + y);
+			SDL_Color color;
+			uint8_t a;
+
+			SDL_GetRGBA(value, format, &color.r, &color.g, &color.b, &a);
+
+			if(keyed && value == format->colorkey)
+				a = SDL_ALPHA_TRANSPARENT;
+
+			out[x] =
+				(uint32_t)((color.r * a + 127) / 255) << m_format->Rshift |
+				(uint32_t)((color.g * a + 127) / 255) << m_format->Gshift |
+				(uint32_t)((color.b * a + 127) / 255) << m_format->Bshift |
+				(uint32_t)a << alpha_shift;
+		}
+	}
+
+	SDL_UnlockSurface(frame);
+	SDL_UnlockSurface(source);
+
+	return frame;
+}
+
+void screen_overlay::push_file(const std::string& file) {
+	surface_region region = m_cache->fetch(file);
+
+	// The copy is all that's needed from now on
+
+	try {
+		m_frames.push_back(premultiply(region));
+	} catch(std::runtime_error e) {
+		m_cache->release(region);
+		throw;
+	}
+
+	m_cache->release(region);
+}
+
+void screen_overlay::clear() {
+	for(
+		std::vector<SDL_Surface*>::iterator iter = m_frames.begin();
+		iter != m_frames.end();
+		iter++
+	) {
+		SDL_FreeSurface(*iter);
+	}
+
+	m_frames.clear();
+	m_start = SDL_GetTicks();
+}
+
+void screen_overlay::frame_time(uint16_t frame_time) {
+	m_frame_time = frame_time > 0 ? frame_time : 1;
+}
+
+void screen_overlay::scroll(float x, float y) {
+	m_scroll_x = x;
+	m_scroll_y = y;
+}
+
+void screen_overlay::opacity(uint8_t opacity, uint32_t time) {
+	m_opacity_from = this->opacity();
+	m_opacity_to = opacity;
+	m_fade_start = SDL_GetTicks();
+	m_fade_time = time;
+}
+
+uint8_t screen_overlay::opacity() const {
+	uint32_t elapsed = SDL_GetTicks() - m_fade_start;
+
+	if(elapsed >= m_fade_time)
+		return m_opacity_to;
+
+	return m_opacity_from + ((int16_t)m_opacity_to - m_opacity_from) * (int32_t)elapsed / (int32_t)m_fade_time;
+}
+
+const overlay_layer* screen_overlay::layer() {
+	uint8_t opacity = this->opacity();
+
+	if(m_frames.empty() || opacity == SDL_ALPHA_TRANSPARENT)
+		return NULL;
+
+	uint32_t elapsed = SDL_GetTicks() - m_start;
+	SDL_Surface* frame = m_frames[(elapsed / m_frame_time) % m_frames.size()];
+
+	m_layer.surface = frame;
+	m_layer.opacity = opacity + (opacity >> 7); // 255 becomes 256
+	// The texture moves the opposite way to where it's looked up
+
+	m_layer.x = -(int32_t)fmod(elapsed * (double)m_scroll_x / 1000, frame->w);
+	m_layer.y = -(int32_t)fmod(elapsed * (double)m_scroll_y / 1000, frame->h);
+
+	return &m_layer;
+}
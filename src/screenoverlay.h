@@ -0,0 +1,94 @@
+/*
+        Copyright (c) 2010, Markus Wagner (bgld)
+        All rights reserved.
+
+        Redistribution and use in source and binary forms, with or without
+        modification, are permitted provided that the following conditions are
+        met:
+        - Redistributions of source code must retain the above copyright
+          notice, this list of conditions and the following disclaimer.
+        - Redistributions in binary form must reproduce the above copyright
+          notice, this list of conditions and the following disclaimer in the
+          documentation and/or other materials provided with the distribution.
+        - Neither the name "fawesome" or "FawesomeEngine" nor the names of its contributors
+          may be used to endorse or promote products derived from this software
+          without specific prior written permission.
+
+        THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+        "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+        LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+        PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL MARKUS WAGNER BE
+        LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+        CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+        SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+        INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+        CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+        ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+        THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef SCREENOVERLAY_H
+#define SCREENOVERLAY_H
+
+#include <vector>
+#include <string>
+#include <stdint.h>
+#include <SDL/SDL.h>
+
+#include "surfacecache.h"
+#include "blitter.h"
+
+
+/**
+ * Animated full-screen texture like a sandstorm, blended over everything while the screen is zoomed.
+ * Frames are copied from the cache once, converted to the screen's format and pre-multiplied by their alpha,
+ * so compositing is one multiply-add per channel pair and pixel. Frames smaller than the screen repeat.
+ */
+class screen_overlay {
+private:
+    surface_cache* m_cache;
+    SDL_PixelFormat* m_format;
+
+    std::vector<SDL_Surface*> m_frames;
+    uint16_t m_frame_time; // Milliseconds per frame
+    uint32_t m_start;
+
+    float m_scroll_x, m_scroll_y; // Pixels per second
+
+    uint8_t m_opacity_from, m_opacity_to;
+    uint32_t m_fade_start, m_fade_time;
+
+    overlay_layer m_layer;
+
+    SDL_Surface* premultiply(const surface_region& region);
+public:
+    /**
+     * @param format
+     * 	The 4 byte format of the surface the overlay is composited over.
+     */
+    screen_overlay(surface_cache* cache, SDL_PixelFormat* format);
+    ~screen_overlay();
+
+    /**
+     * Appends a frame, throws file_not_found_exception.
+     */
+    void push_file(const std::string& file);
+    void clear();
+
+    void frame_time(uint16_t frame_time);
+
+    void scroll(float x, float y);
+
+    /**
+     * Fades the whole overlay to opacity over the given milliseconds, 0 to set it right away.
+     */
+    void opacity(uint8_t opacity, uint32_t time = 0);
+    uint8_t opacity() const;
+
+    /**
+     * What to composite this frame, NULL if there's nothing to see.
+     */
+    const overlay_layer* layer();
+};
+
+#endif // SCREENOVERLAY_H
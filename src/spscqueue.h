@@ -0,0 +1,87 @@
+/*
+        Copyright (c) 2010, Markus Wagner (bgld)
+        All rights reserved.
+
+        Redistribution and use in source and binary forms, with or without
+        modification, are permitted provided that the following conditions are
+        met:
+        - Redistributions of source code must retain the above copyright
+          notice, this list of conditions and the following disclaimer.
+        - Redistributions in binary form must reproduce the above copyright
+          notice, this list of conditions and the following disclaimer in the
+          documentation and/or other materials provided with the distribution.
+        - Neither the name "fawesome" or "FawesomeEngine" nor the names of its contributors
+          may be used to endorse or promote products derived from this software
+          without specific prior written permission.
+
+        THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+        "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+        LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+        PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL MARKUS WAGNER BE
+        LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+        CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+        SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+        INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+        CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+        ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+        THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef SPSCQUEUE_H
+#define SPSCQUEUE_H
+
+#include <stdint.h>
+
+
+/**
+ * Fixed size queue between exactly one producer and one consumer thread, without locks.
+ * Each side only writes its own index, the barriers make sure an item is complete before the other side sees it.
+ * N has to be a power of two so the indices can wrap around freely.
+ */
+template<class T, uint32_t N>
+class spsc_queue {
+private:
+    T m_items[N];
+
+    volatile uint32_t m_head; // Next to pop, written by the consumer
+    volatile uint32_t m_tail; // Next to push, written by the producer
+public:
+    spsc_queue() : m_head(0), m_tail(0) {}
+
+    /**
+     * Producer side, false if the queue is full.
+     */
+    bool push(const T& item) {
+        uint32_t tail = m_tail;
+
+        if(tail - m_head == N)
+            return false;
+
+        m_items[tail % N] = item;
+
+        __sync_synchronize();
+        m_tail = tail + 1;
+
+        return true;
+    }
+
+    /**
+     * Consumer side, false if the queue is empty.
+     */
+    bool pop(T& item) {
+        uint32_t head = m_head;
+
+        if(head == m_tail)
+            return false;
+
+        __sync_synchronize();
+        item = m_items[head % N];
+
+        __sync_synchronize();
+        m_head = head + 1;
+
+        return true;
+    }
+};
+
+#endif // SPSCQUEUE_H
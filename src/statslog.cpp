@@ -0,0 +1,91 @@
+/*
+	Copyright (c) 2010, Markus Wagner (bgld)
+	All rights reserved.
+
+	Redistribution and use in source and binary forms, with or without
+	modification, are permitted provided that the following conditions are
+	met:
+	- Redistributions of source code must retain the above copyright
+	  notice, this list of conditions and the following disclaimer.
+	- Redistributions in binary form must reproduce the above copyright
+	  notice, this list of conditions and the following disclaimer in the
+	  documentation and/or other materials provided with the distribution.
+	- Neither the name "fawesome" or "FawesomeEngine" nor the names of its contributors
+	  may be used to endorse or promote products derived from this software
+	  without specific prior written permission.
+
+	THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+	"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+	LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+	PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL MARKUS WAGNER BE
+	LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+	CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+	SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+	INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+	CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+	ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+	THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "statslog.h"
+
+#include <SDL/SDL.h>
+
+#include "tclbind.h"
+
+stats_log::stats_log(const std::string& file_name) {
+	stream.open(file_name.c_str());
+
+	if(!stream.good())
+		throw std::runtime_error("Couldn't open stats log " + file_name);
+
+	stream << "ticks,frames,blits,pixels,culled,surfaces_created,surfaces_freed,obstruction_tests,cache_hits,cache_misses,events,evals" << std::endl;
+
+	next_tick = SDL_GetTicks() + 1000;
+	frames = 0;
+
+	last_hits = 0;
+	last_misses = 0;
+	last_events = 0;
+	last_evals = 0;
+}
+
+void stats_log::update(const screen* screen, const event_queue* queue, const tcl_bind* bind) {
+	frames++;
+
+	uint32_t ticks = SDL_GetTicks();
+
+	if(ticks < next_tick)
+		return;
+
+	const frame_counters& totals = screen->total_counters();
+
+	uint32_t hits = screen->cache()->hits();
+	uint32_t misses = screen->cache()->misses();
+	uint32_t events = queue->dispatched();
+	uint32_t evals = bind->evals();
+
+	stream
+		<< ticks << ','
+		<< frames << ','
+		<< totals.blits - last_totals.blits << ','
+		<< totals.pixels - last_totals.pixels << ','
+		<< totals.culled - last_totals.culled << ','
+		<< totals.surfaces_created - last_totals.surfaces_created << ','
+		<< totals.surfaces_freed - last_totals.surfaces_freed << ','
+		<< totals.obstruction_tests - last_totals.obstruction_tests << ','
+		<< hits - last_hits << ','
+		<< misses - last_misses << ','
+		<< events - last_events << ','
+		<< evals - last_evals
+		<< std::endl;
+
+	last_totals = totals;
+	last_hits = hits;
+	last_misses = misses;
+	last_events = events;
+	last_evals = evals;
+
+	frames = 0;
+	next_tick = ticks + 1000;
+}
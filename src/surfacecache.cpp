@@ -30,31 +30,297 @@
 #include "surfacecache.h"
 
 #include <iostream>
+#include <stdexcept>
 #include <SDL/SDL_image.h>
 
 #include "filenotfoundexception.h"
 #include "file.h"
 
-surface_cache::surface_cache() { }
+surface_cache::surface_cache(uint32_t budget, atlas* atlas, asset_archive* archive, pixel_cache* pixels) {
+	m_budget = budget;
+	m_atlas = atlas;
+	m_archive = archive;
+	m_pixels = pixels;
+	m_bytes = 0;
 
-SDL_Surface* surface_cache::fetch(const std::string &name) {
-	SDL_Surface* image;
+	m_hits = 0;
+	m_misses = 0;
+	m_evictions = 0;
+	m_load_ticks = 0;
+}
+
+surface_cache::~surface_cache() {
+	for(
+		surface_map::iterator iter = surfaces.begin();
+		iter != surfaces.end();
+		iter++
+	) {
+		if(!(*iter).second.packed)
+			SDL_FreeSurface((*iter).second.region.surface);
+	}
 
+	delete m_atlas;
+	delete m_archive; // Unmap only after all surfaces pointing into it are gone
+	delete m_pixels;
+}
+
+region_key surface_cache::key(const surface_region& region) {
+	return std::make_pair(region.surface, ((uint32_t)(uint16_t)region.rect.x << 16) | (uint16_t)region.rect.y);
+}
+
+surface_region surface_cache::fetch(const std::string &name) {
 	std::string file_name = file(name);
 
 	surface_map::iterator result = surfaces.find(file_name);
 
 	if(result != surfaces.end()) {
-		image = (*result).second;
+		m_hits++;
+
+		(*result).second.refs++;
+		touch((*result).second, file_name);
+
+		return (*result).second.region;
+	}
+
+	m_misses++;
+
+	uint32_t start = SDL_GetTicks();
+
+	SDL_Surface* image = load(name, file_name);
+
+	if(image == NULL) {
+		throw file_not_found_exception(file_name);
+	}
+
+	cache_entry entry;
+
+	if(m_atlas != NULL && m_atlas->fits(image)) {
+		try {
+			entry.region = m_atlas->pack(image);
+		} catch(std::runtime_error e) {
+			SDL_FreeSurface(image);
+			throw;
+		}
+
+		entry.packed = true;
+		entry.bytes = 0; // Counted with the whole sheet, see bytes()
+
+		SDL_FreeSurface(image);
+	} else {
+		entry.region.surface = image;
+		entry.region.rect = image->clip_rect;
+		entry.packed = false;
+		entry.bytes = (image->flags & SDL_PREALLOC) ? 0 : image->pitch * image->h; // Mapped pixels aren't ours
+	}
+
+	m_load_ticks += SDL_GetTicks() - start;
+
+	entry.refs = 1;
+	entry.lru = lru.insert(lru.begin(), file_name);
+
+	surfaces.insert(std::make_pair(file_name, entry));
+	owners.insert(std::make_pair(key(entry.region), file_name));
+
+	m_bytes += entry.bytes;
+
+	evict();
+
+	return entry.region;
+}
+
+SDL_Surface* surface_cache::load(const std::string& name, const std::string& file_name) const {
+	const asset_entry* entry = m_archive != NULL ? m_archive->find(name) : NULL;
+
+	if(entry != NULL && entry->type == asset_archive::PIXELS) {
+		SDL_Surface* mapped = SDL_CreateRGBSurfaceFrom(
+			(void*)m_archive->data(entry),
+			entry->width,
+			entry->height,
+			entry->bpp,
+			entry->pitch,
+
+			entry->rmask,
+			entry->gmask,
+			entry->bmask,
+			entry->amask
+		);
+
+		// Packed offline as ARGB, which is the display format on the usual 32 bit screens, everywhere else it is converted once
+
+		if(mapped == NULL || display_format(mapped->format))
+			return mapped;
+
+		SDL_Surface* converted = SDL_DisplayFormatAlpha(mapped);
+
+		if(converted == NULL)
+			return mapped;
+
+		SDL_FreeSurface(mapped);
+
+		return converted;
+	}
+
+	time_t mtime = 0;
+
+	if(m_pixels != NULL) {
+		mtime = entry != NULL ? m_archive->modified() : pixel_cache::modified(file_name);
+
+		SDL_Surface* cached = m_pixels->load(file_name, mtime);
+
+		if(cached != NULL)
+			return cached;
+	}
+
+	SDL_Surface* image;
+
+	if(entry != NULL) {
+		image = IMG_Load_RW(SDL_RWFromConstMem(m_archive->data(entry), entry->size), 1);
 	} else {
 		image = IMG_Load(file_name.c_str());
+	}
+
+	if(image == NULL || m_pixels == NULL)
+		return image;
+
+	SDL_Surface* converted = SDL_DisplayFormatAlpha(image);
+
+	if(converted == NULL)
+		return image;
 
-		if(image == NULL) {
-			throw file_not_found_exception(file_name);
+	SDL_FreeSurface(image);
+
+	m_pixels->store(file_name, mtime, converted);
+
+	return converted;
+}
+
+bool surface_cache::display_format(const SDL_PixelFormat* format) {
+	// What SDL_DisplayFormatAlpha makes of a surface, found out once with a single pixel
+
+	static bool probed = false;
+	static SDL_PixelFormat display;
+
+	if(!probed) {
+		SDL_Surface* probe = SDL_CreateRGBSurface(SDL_SWSURFACE, 1, 1, 32, 0x00FF0000, 0x0000FF00, 0x000000FF, 0xFF000000);
+		SDL_Surface* converted = probe != NULL ? SDL_DisplayFormatAlpha(probe) : NULL;
+
+		if(converted == NULL) {
+			SDL_FreeSurface(probe);
+			return false;
+		}
+
+		display = *converted->format;
+		display.palette = NULL;
+		probed = true;
+
+		SDL_FreeSurface(converted);
+		SDL_FreeSurface(probe);
+	}
+
+	return
+		format->BitsPerPixel == display.BitsPerPixel &&
+		format->Rmask == display.Rmask &&
+		format->Gmask == display.Gmask &&
+		format->Bmask == display.Bmask &&
+		format->Amask == display.Amask;
+}
+
+void surface_cache::retain(const surface_region& region) {
+	owner_map::iterator owner = owners.find(key(region));
+
+	if(owner == owners.end())
+		return;
+
+	cache_entry& entry = surfaces[(*owner).second];
+
+	entry.refs++;
+	touch(entry, (*owner).second);
+}
+
+void surface_cache::release(const surface_region& region) {
+	owner_map::iterator owner = owners.find(key(region));
+
+	if(owner == owners.end())
+		return;
+
+	cache_entry& entry = surfaces[(*owner).second];
+
+	if(entry.refs > 0)
+		entry.refs--;
+
+	if(entry.refs == 0)
+		evict();
+}
+
+void surface_cache::touch(cache_entry& entry, const std::string& file_name) {
+	lru.erase(entry.lru);
+	entry.lru = lru.insert(lru.begin(), file_name);
+}
+
+void surface_cache::evict() {
+	std::list<std::string>::iterator iter = lru.end();
+
+	// Walk from the least recently used end; referenced surfaces are never freed, so the budget is a soft limit
+
+	while(bytes() > m_budget && iter != lru.begin()) {
+		iter--;
+
+		surface_map::iterator result = surfaces.find(*iter);
+		cache_entry& entry = (*result).second;
+
+		if(entry.refs > 0)
+			continue;
+
+		m_bytes -= entry.bytes;
+		m_evictions++;
+
+		owners.erase(key(entry.region));
+
+		if(entry.packed) {
+			m_atlas->release(entry.region);
+		} else {
+			SDL_FreeSurface(entry.region.surface);
 		}
 
-		surfaces.insert(std::make_pair(file_name, image));
+		iter = lru.erase(iter);
+		surfaces.erase(result);
 	}
+}
+
+uint32_t surface_cache::budget() const {
+	return m_budget;
+}
+
+void surface_cache::budget(uint32_t budget) {
+	m_budget = budget;
+
+	evict();
+}
+
+uint32_t surface_cache::hits() const {
+	return m_hits;
+}
+
+uint32_t surface_cache::misses() const {
+	return m_misses;
+}
+
+uint32_t surface_cache::evictions() const {
+	return m_evictions;
+}
+
+uint32_t surface_cache::bytes() const {
+	return m_bytes + (m_atlas != NULL ? m_atlas->bytes() : 0);
+}
+
+uint32_t surface_cache::count() const {
+	return surfaces.size();
+}
+
+uint32_t surface_cache::load_ticks() const {
+	return m_load_ticks;
+}
 
-	return image;
+uint32_t surface_cache::sheets() const {
+	return m_atlas != NULL ? m_atlas->count() : 0;
 }
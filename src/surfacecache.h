@@ -31,19 +31,102 @@
 #define SURFACECACHE_H
 
 #include <map>
+#include <list>
 #include <string>
+#include <stdint.h>
 #include <SDL/SDL.h>
 
+#include "atlas.h"
+#include "archive.h"
+#include "pixelcache.h"
 
-typedef std::map<std::string, SDL_Surface*> surface_map;
 
+struct cache_entry {
+    surface_region region;
+    bool packed;
+
+    uint32_t refs;
+    uint32_t bytes;
+
+    std::list<std::string>::iterator lru;
+};
+
+typedef std::map<std::string, cache_entry> surface_map;
+typedef std::pair<SDL_Surface*, uint32_t> region_key; // Surface and packed rect position
+typedef std::map<region_key, std::string> owner_map;
+
+/**
+ * Loads images once and hands out shared surfaces.
+ * Surfaces are reference counted by the sprites using them; unreferenced ones stay resident
+ * until the byte budget is exceeded and are then evicted least recently used first.
+ * Small images are packed into shared atlas sheets, so a fetched surface may only be valid within its rect.
+ * Names found in the asset archive are read from there instead of the file system.
+ * Decoded images are converted to display format and kept in the pixel cache for the next start.
+ */
 class surface_cache {
 private:
     surface_map surfaces;
+    owner_map owners;
+
+    std::list<std::string> lru; // Front is the most recently used entry
+
+    uint32_t m_budget;
+    uint32_t m_bytes;
+
+    uint32_t m_hits, m_misses, m_evictions;
+    uint32_t m_load_ticks;
+
+    atlas* m_atlas;
+    asset_archive* m_archive;
+    pixel_cache* m_pixels;
+
+    static region_key key(const surface_region& region);
+
+    SDL_Surface* load(const std::string& name, const std::string& file_name) const;
+
+    /**
+     * Whether surfaces in format can be blitted like SDL_DisplayFormatAlpha results, without conversion.
+     */
+    static bool display_format(const SDL_PixelFormat* format);
+
+    void touch(cache_entry& entry, const std::string& file_name);
+    void evict();
 public:
-    surface_cache();
+    /**
+     * @param budget
+     * 	Total bytes the cache aims to stay under. Referenced surfaces are never evicted, so this is a soft limit.
+     */
+    surface_cache(uint32_t budget, atlas* atlas = NULL, asset_archive* archive = NULL, pixel_cache* pixels = NULL);
+    ~surface_cache();
+
+    /**
+     * Returns the region holding an image file and adds a reference to it. Every fetch has to be paired with a release.
+     */
+    surface_region fetch(const std::string &file);
+
+    /**
+     * Drops a reference obtained by fetch. Regions not owned by the cache are ignored.
+     */
+    void release(const surface_region& region);
+
+    /**
+     * Adds another reference to a region obtained by fetch, to be dropped by its own release.
+     */
+    void retain(const surface_region& region);
+
+    uint32_t budget() const;
+    void budget(uint32_t budget);
 
-    SDL_Surface* fetch(const std::string &file);
+    uint32_t hits() const;
+    uint32_t misses() const;
+    uint32_t evictions() const;
+    /**
+     * Memory held by loaded surfaces, atlas sheets counted as a whole however full they are.
+     */
+    uint32_t bytes() const;
+    uint32_t count() const;
+    uint32_t load_ticks() const;
+    uint32_t sheets() const;
 };
 
 #endif // SURFACECACHE_H
@@ -36,9 +36,12 @@
 #include "globals.h"
 #include "constants.h"
 #include "file.h"
+#include "profiler.h"
+#include "inputstate.h"
 
 #include "gfx/sprite.h"
 #include "gfx/map.h"
+#include "gfx/emitter.h"
 
 
 tcl_bind* bind;
@@ -66,9 +69,10 @@ void push_files(T* sprite, Tcl_Interp* interp, int objc, Tcl_Obj* const* objv) {
 	Tcl_Obj** file;
 	int file_count;
 
-	char* file_string;
 	int dir;
 
+	file_list files; // Handed over in one go, so the shared animation is only looked up once
+
 	for(int i = 1; i < objc - 1; i++) {
 		switch(i) {
 		case 1:
@@ -88,17 +92,17 @@ void push_files(T* sprite, Tcl_Interp* interp, int objc, Tcl_Obj* const* objv) {
 		Tcl_ListObjGetElements(interp, objv[i], &file_count, &file);
 
 		for(int j = 0; j < file_count; j++) {
-			file_string = Tcl_GetStringFromObj(*file, NULL);
-			//std::cout << file_string << std::endl;
-			try {
-				sprite->push_file(dir, file_string);
-			} catch(file_not_found_exception e) {
-				exception_message(e, FILE_NOT_FOUND_MSG);
-			}
+			files.push_back(std::make_pair(dir, std::string(Tcl_GetStringFromObj(*file, NULL))));
 
 			file++;
 		}
 	}
+
+	try {
+		sprite->push_files(files);
+	} catch(file_not_found_exception e) {
+		exception_message(e, FILE_NOT_FOUND_MSG);
+	}
 }
 
 template<class T>
@@ -227,6 +231,70 @@ int tcl_tint(ClientData, Tcl_Interp* interp, int objc, Tcl_Obj* const* objv) {
 	return TCL_OK;
 }
 
+int tcl_overlay(ClientData, Tcl_Interp* interp, int objc, Tcl_Obj* const* objv) {
+	if(objc < 2)
+		return TCL_ERROR;
+
+	screen_overlay* overlay = bind->m_screen->overlay();
+	std::string parameter = Tcl_GetStringFromObj(objv[1], NULL);
+
+	if(parameter == "frames" && (objc == 3 || objc == 4)) {
+		Tcl_Obj** file;
+		int file_count;
+
+		if(Tcl_ListObjGetElements(interp, objv[2], &file_count, &file) != TCL_OK)
+			return TCL_ERROR;
+
+		int frame_time;
+
+		if(objc == 4) {
+			if(Tcl_GetIntFromObj(interp, objv[3], &frame_time) != TCL_OK || frame_time <= 0 || frame_time > 0xffff)
+				return TCL_ERROR;
+
+			overlay->frame_time(frame_time);
+		}
+
+		overlay->clear();
+
+		try {
+			for(int i = 0; i < file_count; i++)
+				overlay->push_file(Tcl_GetStringFromObj(file[i], NULL));
+		} catch(file_not_found_exception e) {
+			exception_message(e, FILE_NOT_FOUND_MSG);
+		} catch(std::runtime_error e) {
+			Tcl_SetObjResult(interp, Tcl_NewStringObj(e.what(), -1));
+			return TCL_ERROR;
+		}
+	} else if(parameter == "opacity" && (objc == 2 || objc == 3 || objc == 4)) {
+		if(objc == 2) {
+			Tcl_SetObjResult(interp, Tcl_NewIntObj(overlay->opacity()));
+			return TCL_OK;
+		}
+
+		int opacity;
+		int time = 0;
+
+		if(Tcl_GetIntFromObj(interp, objv[2], &opacity) != TCL_OK || opacity < 0 || opacity > 255)
+			return TCL_ERROR;
+
+		if(objc == 4 && (Tcl_GetIntFromObj(interp, objv[3], &time) != TCL_OK || time < 0))
+			return TCL_ERROR;
+
+		overlay->opacity(opacity, time);
+	} else if(parameter == "scroll" && objc == 4) {
+		double x, y;
+
+		if(Tcl_GetDoubleFromObj(interp, objv[2], &x) != TCL_OK || Tcl_GetDoubleFromObj(interp, objv[3], &y) != TCL_OK)
+			return TCL_ERROR;
+
+		overlay->scroll(x, y);
+	} else {
+		return TCL_ERROR;
+	}
+
+	return TCL_OK;
+}
+
 int tcl_sprite(ClientData dummy, Tcl_Interp* interp, int objc, Tcl_Obj* const* objv) {
 	return generic_sprite<controllable_sprite>(dummy, interp, objc, objv);
 }
@@ -292,6 +360,108 @@ int tcl_follow(ClientData, Tcl_Interp* interp, int objc, Tcl_Obj * const* objv)
 	return TCL_OK;
 }
 
+int tcl_raw_motion(ClientData, Tcl_Interp* interp, int objc, Tcl_Obj * const* objv) {
+	if(objc != 2 && objc != 3)
+		return TCL_ERROR;
+
+	event_handler* handler;
+
+	try {
+		handler = find_handle<event_handler>(interp, objv[1]);
+	} catch(std::runtime_error e) {
+		Tcl_SetObjResult(interp, Tcl_NewStringObj(e.what(), -1));
+		return TCL_ERROR;
+	}
+
+	if(objc == 2) {
+		Tcl_SetObjResult(interp, Tcl_NewBooleanObj(handler->raw_motion()));
+		return TCL_OK;
+	}
+
+	int raw;
+
+	if(Tcl_GetBooleanFromObj(interp, objv[2], &raw) != TCL_OK)
+		return TCL_ERROR;
+
+	handler->raw_motion(raw);
+
+	return TCL_OK;
+}
+
+int tcl_input(ClientData, Tcl_Interp* interp, int objc, Tcl_Obj* const* objv) {
+	if(objc < 2)
+		return TCL_ERROR;
+
+	std::string parameter = Tcl_GetStringFromObj(objv[1], NULL);
+
+	if(parameter == "pointer" && objc == 2) {
+		Tcl_Obj* position = Tcl_NewListObj(0, NULL);
+
+		Tcl_ListObjAppendElement(interp, position, Tcl_NewIntObj(input_state::pointer_x()));
+		Tcl_ListObjAppendElement(interp, position, Tcl_NewIntObj(input_state::pointer_y()));
+
+		Tcl_SetObjResult(interp, position);
+		return TCL_OK;
+	}
+
+	if(objc != 3 && objc != 4)
+		return TCL_ERROR;
+
+	int index;
+
+	if(Tcl_GetIntFromObj(interp, objv[2], &index) != TCL_OK || index < 0)
+		return TCL_ERROR;
+
+	if(parameter == "axis" && objc == 3) {
+		Tcl_SetObjResult(interp, Tcl_NewIntObj(index < 0xff ? input_state::axis(index) : 0));
+		return TCL_OK;
+	}
+
+	// key, button and joy take an optional edge: down (the default), pressed or released this frame, keys also held
+
+	std::string edge = objc == 4 ? Tcl_GetStringFromObj(objv[3], NULL) : "down";
+	bool state;
+
+	if(parameter == "key" && index < SDLK_LAST) {
+		SDLKey key = (SDLKey)index;
+
+		if(edge == "down")
+			state = input_state::down(key);
+		else if(edge == "pressed")
+			state = input_state::pressed(key);
+		else if(edge == "released")
+			state = input_state::released(key);
+		else if(edge == "held")
+			state = input_state::held(key);
+		else
+			return TCL_ERROR;
+	} else if(parameter == "button" && index < 0xff) {
+		if(edge == "down")
+			state = input_state::button(index);
+		else if(edge == "pressed")
+			state = input_state::button_pressed(index);
+		else if(edge == "released")
+			state = input_state::button_released(index);
+		else
+			return TCL_ERROR;
+	} else if(parameter == "joy" && index < 0xff) {
+		if(edge == "down")
+			state = input_state::joy_down(index);
+		else if(edge == "pressed")
+			state = input_state::joy_pressed(index);
+		else if(edge == "released")
+			state = input_state::joy_released(index);
+		else
+			return TCL_ERROR;
+	} else {
+		return TCL_ERROR;
+	}
+
+	Tcl_SetObjResult(interp, Tcl_NewBooleanObj(state));
+
+	return TCL_OK;
+}
+
 int tcl_player(ClientData, Tcl_Interp* interp, int objc, Tcl_Obj * const* objv) {
 	if(objc != 6)
 		return TCL_ERROR;
@@ -350,6 +520,183 @@ int tcl_obstruct(ClientData, Tcl_Interp* interp, int objc, Tcl_Obj * const* objv
 	return TCL_OK;
 }
 
+int tcl_sheet(ClientData, Tcl_Interp* interp, int objc, Tcl_Obj * const* objv) {
+	if(objc != 6 && objc != 7)
+		return TCL_ERROR;
+
+	char* dir_name = Tcl_GetStringFromObj(objv[2], NULL);
+	int16_t dir;
+
+	if(strcmp(dir_name, "n") == 0) {
+		dir = sprite::DIR_N;
+	} else if(strcmp(dir_name, "s") == 0) {
+		dir = sprite::DIR_S;
+	} else if(strcmp(dir_name, "w") == 0) {
+		dir = sprite::DIR_W;
+	} else if(strcmp(dir_name, "e") == 0) {
+		dir = sprite::DIR_E;
+	} else if(strcmp(dir_name, "none") == 0) {
+		dir = sprite::DIR_NONE;
+	} else {
+		return TCL_ERROR;
+	}
+
+	int frame_w;
+	int frame_h;
+
+	if(Tcl_GetIntFromObj(interp, objv[4], &frame_w) != TCL_OK || Tcl_GetIntFromObj(interp, objv[5], &frame_h) != TCL_OK)
+		return TCL_ERROR;
+
+	if(frame_w <= 0 || frame_h <= 0)
+		return TCL_ERROR;
+
+	std::vector<uint16_t> cells;
+
+	if(objc == 7) {
+		Tcl_Obj** cell;
+		int cell_count;
+
+		if(Tcl_ListObjGetElements(interp, objv[6], &cell_count, &cell) != TCL_OK)
+			return TCL_ERROR;
+
+		for(int i = 0; i < cell_count; i++) {
+			int index;
+
+			if(Tcl_GetIntFromObj(interp, cell[i], &index) != TCL_OK || index < 0)
+				return TCL_ERROR;
+
+			cells.push_back(index);
+		}
+	}
+
+	try {
+		find_handle<sprite>(interp, objv[1])->push_sheet(dir, Tcl_GetStringFromObj(objv[3], NULL), frame_w, frame_h, cells);
+	} catch(file_not_found_exception e) {
+		exception_message(e, FILE_NOT_FOUND_MSG);
+	} catch(std::runtime_error e) {
+		Tcl_SetObjResult(interp, Tcl_NewStringObj(e.what(), -1));
+		return TCL_ERROR;
+	}
+
+	return TCL_OK;
+}
+
+int tcl_clip(ClientData, Tcl_Interp* interp, int objc, Tcl_Obj * const* objv) {
+	if(objc != 3)
+		return TCL_ERROR;
+
+	Tcl_Obj** duration;
+	int duration_count;
+
+	if(Tcl_ListObjGetElements(interp, objv[2], &duration_count, &duration) != TCL_OK || duration_count == 0)
+		return TCL_ERROR;
+
+	std::vector<uint16_t> durations;
+
+	for(int i = 0; i < duration_count; i++) {
+		int ms;
+
+		if(Tcl_GetIntFromObj(interp, duration[i], &ms) != TCL_OK || ms <= 0 || ms > 0xffff)
+			return TCL_ERROR;
+
+		durations.push_back(ms);
+	}
+
+	try {
+		find_handle<sprite>(interp, objv[1])->clip(durations);
+	} catch(std::runtime_error e) {
+		Tcl_SetObjResult(interp, Tcl_NewStringObj(e.what(), -1));
+		return TCL_ERROR;
+	}
+
+	return TCL_OK;
+}
+
+int tcl_emitter(ClientData, Tcl_Interp* interp, int objc, Tcl_Obj * const* objv) {
+	if(objc != 2 && objc != 3)
+		return TCL_ERROR;
+
+	emitter* new_emitter = bind->m_screen->new_sprite<emitter>(Tcl_GetStringFromObj(objv[1], NULL));
+
+	if(new_emitter == NULL)
+		return TCL_ERROR;
+
+	if(objc == 3) {
+		long handle;
+		Tcl_GetLongFromObj(interp, objv[2], &handle);
+
+		handle_container::iterator result = handles.find(handle);
+
+		if(result == handles.end())
+			return TCL_ERROR;
+
+		(*result).second->add_follower(new_emitter);
+
+		Tcl_SetObjResult(interp, Tcl_NewIntObj(insert_handle(new_emitter, (*result).second)));
+	} else {
+		Tcl_SetObjResult(interp, Tcl_NewIntObj(insert_handle(new_emitter)));
+	}
+
+	return TCL_OK;
+}
+
+int tcl_emit(ClientData, Tcl_Interp* interp, int objc, Tcl_Obj * const* objv) {
+	if(objc < 2)
+		return TCL_ERROR;
+
+	emitter* victim;
+
+	try {
+		victim = find_handle<emitter>(interp, objv[1]);
+	} catch(std::runtime_error e) {
+		Tcl_SetObjResult(interp, Tcl_NewStringObj(e.what(), -1));
+		return TCL_ERROR;
+	}
+
+	// Without a parameter, tell how many particles are alive
+
+	if(objc == 2) {
+		Tcl_SetObjResult(interp, Tcl_NewLongObj(victim->count()));
+		return TCL_OK;
+	}
+
+	std::string parameter = Tcl_GetStringFromObj(objv[2], NULL);
+	std::vector<double> values;
+
+	for(int i = 3; i < objc; i++) {
+		double value;
+
+		if(Tcl_GetDoubleFromObj(interp, objv[i], &value) != TCL_OK)
+			return TCL_ERROR;
+
+		values.push_back(value);
+	}
+
+	size_t count = values.size();
+
+	if(parameter == "rate" && count == 1 && values[0] >= 0) {
+		victim->rate(values[0]);
+	} else if(parameter == "max" && count == 1 && values[0] >= 0) {
+		victim->capacity(values[0]);
+	} else if(parameter == "burst" && count == 1 && values[0] >= 0) {
+		victim->burst(values[0]);
+	} else if(parameter == "life" && (count == 1 || count == 2) && values[0] >= 0) {
+		victim->life(values[0], count == 2 ? values[1] : 0);
+	} else if(parameter == "velocity" && (count == 2 || count == 4)) {
+		victim->velocity(values[0], values[1], count == 4 ? values[2] : 0, count == 4 ? values[3] : 0);
+	} else if(parameter == "accel" && count == 2) {
+		victim->acceleration(values[0], values[1]);
+	} else if(parameter == "area" && count == 2 && values[0] >= 0 && values[1] >= 0) {
+		victim->area(values[0], values[1]);
+	} else if(parameter == "fade" && count == 2 && values[0] >= 0 && values[1] >= 0) {
+		victim->fade(values[0], values[1]);
+	} else {
+		return TCL_ERROR;
+	}
+
+	return TCL_OK;
+}
+
 int tcl_animate(ClientData, Tcl_Interp* interp, int objc, Tcl_Obj * const* objv) {
 	if(objc != 2)
 		return TCL_ERROR;
@@ -582,23 +929,257 @@ int tcl_text(ClientData, Tcl_Interp* interp, int objc, Tcl_Obj * const* objv) {
 }
 
 int tcl_sound(ClientData, Tcl_Interp* interp, int objc, Tcl_Obj * const* objv) {
-	if(objc != 2)
+	if(objc < 2 || objc > 4)
 		return TCL_ERROR;
 
 	std::string file = Tcl_GetStringFromObj(objv[1], NULL);
 
-	bind->m_player->play_audio(file);
+	int volume = 255;
+	int loop = 0;
+
+	if(objc >= 3 && (Tcl_GetIntFromObj(interp, objv[2], &volume) != TCL_OK || volume < 0 || volume > 255))
+		return TCL_ERROR;
+
+	if(objc == 4 && Tcl_GetBooleanFromObj(interp, objv[3], &loop) != TCL_OK)
+		return TCL_ERROR;
+
+	uint32_t handle = 0;
+
+	try {
+		handle = bind->m_player->play(file, volume, loop);
+	} catch(file_not_found_exception e) {
+		exception_message(e, FILE_NOT_FOUND_MSG);
+	} catch(std::runtime_error e) {
+		Tcl_SetObjResult(interp, Tcl_NewStringObj(e.what(), -1));
+		return TCL_ERROR;
+	}
+
+	Tcl_SetObjResult(interp, Tcl_NewLongObj(handle));
 
 	return TCL_OK;
 }
 
-int tcl_music(ClientData, Tcl_Interp* interp, int objc, Tcl_Obj * const* objv) {
+int tcl_stop(ClientData, Tcl_Interp* interp, int objc, Tcl_Obj * const* objv) {
 	if(objc != 2)
 		return TCL_ERROR;
 
+	long handle;
+
+	if(Tcl_GetLongFromObj(interp, objv[1], &handle) != TCL_OK)
+		return TCL_ERROR;
+
+	bind->m_player->stop(handle);
+
+	return TCL_OK;
+}
+
+int tcl_volume(ClientData, Tcl_Interp* interp, int objc, Tcl_Obj * const* objv) {
+	if(objc != 3)
+		return TCL_ERROR;
+
+	long handle;
+	int volume;
+
+	if(Tcl_GetLongFromObj(interp, objv[1], &handle) != TCL_OK)
+		return TCL_ERROR;
+
+	if(Tcl_GetIntFromObj(interp, objv[2], &volume) != TCL_OK || volume < 0 || volume > 255)
+		return TCL_ERROR;
+
+	bind->m_player->volume(handle, volume);
+
+	return TCL_OK;
+}
+
+int tcl_preload(ClientData, Tcl_Interp* interp, int objc, Tcl_Obj * const* objv) {
+	sample_cache* samples = bind->m_player->samples();
+
+	if(samples == NULL)
+		return TCL_OK;
+
+	try {
+		for(int i = 1; i < objc; i++)
+			samples->preload(Tcl_GetStringFromObj(objv[i], NULL));
+	} catch(file_not_found_exception e) {
+		exception_message(e, FILE_NOT_FOUND_MSG);
+	} catch(std::runtime_error e) {
+		Tcl_SetObjResult(interp, Tcl_NewStringObj(e.what(), -1));
+		return TCL_ERROR;
+	}
+
+	return TCL_OK;
+}
+
+int tcl_music(ClientData, Tcl_Interp* interp, int objc, Tcl_Obj * const* objv) {
+	if(objc < 2 || objc > 4)
+		return TCL_ERROR;
+
 	std::string file = Tcl_GetStringFromObj(objv[1], NULL);
 
-	bind->m_player->play_audio_loop(file);
+	int fade = 0;
+	int loop = 1;
+
+	if(objc >= 3 && (Tcl_GetIntFromObj(interp, objv[2], &fade) != TCL_OK || fade < 0))
+		return TCL_ERROR;
+
+	if(objc == 4 && Tcl_GetBooleanFromObj(interp, objv[3], &loop) != TCL_OK)
+		return TCL_ERROR;
+
+	bind->m_player->music(file, fade, loop);
+
+	return TCL_OK;
+}
+
+int tcl_music_volume(ClientData, Tcl_Interp* interp, int objc, Tcl_Obj * const* objv) {
+	if(objc != 2)
+		return TCL_ERROR;
+
+	int volume;
+
+	if(Tcl_GetIntFromObj(interp, objv[1], &volume) != TCL_OK || volume < 0 || volume > 255)
+		return TCL_ERROR;
+
+	bind->m_player->music_level(volume);
+
+	return TCL_OK;
+}
+
+int tcl_cache_stats(ClientData, Tcl_Interp* interp, int objc, Tcl_Obj * const*) {
+	if(objc != 1)
+		return TCL_ERROR;
+
+	surface_cache* cache = bind->m_screen->cache();
+
+	uint32_t lookups = cache->hits() + cache->misses();
+
+	Tcl_Obj* stats = Tcl_NewListObj(0, NULL);
+
+	Tcl_ListObjAppendElement(interp, stats, Tcl_NewStringObj("hits", -1));
+	Tcl_ListObjAppendElement(interp, stats, Tcl_NewLongObj(cache->hits()));
+	Tcl_ListObjAppendElement(interp, stats, Tcl_NewStringObj("misses", -1));
+	Tcl_ListObjAppendElement(interp, stats, Tcl_NewLongObj(cache->misses()));
+	Tcl_ListObjAppendElement(interp, stats, Tcl_NewStringObj("hit_rate", -1));
+	Tcl_ListObjAppendElement(interp, stats, Tcl_NewDoubleObj(lookups > 0 ? (double)cache->hits() / lookups : 0.0));
+	Tcl_ListObjAppendElement(interp, stats, Tcl_NewStringObj("evictions", -1));
+	Tcl_ListObjAppendElement(interp, stats, Tcl_NewLongObj(cache->evictions()));
+	Tcl_ListObjAppendElement(interp, stats, Tcl_NewStringObj("surfaces", -1));
+	Tcl_ListObjAppendElement(interp, stats, Tcl_NewLongObj(cache->count()));
+	Tcl_ListObjAppendElement(interp, stats, Tcl_NewStringObj("sheets", -1));
+	Tcl_ListObjAppendElement(interp, stats, Tcl_NewLongObj(cache->sheets()));
+	Tcl_ListObjAppendElement(interp, stats, Tcl_NewStringObj("bytes", -1));
+	Tcl_ListObjAppendElement(interp, stats, Tcl_NewLongObj(cache->bytes()));
+	Tcl_ListObjAppendElement(interp, stats, Tcl_NewStringObj("budget", -1));
+	Tcl_ListObjAppendElement(interp, stats, Tcl_NewLongObj(cache->budget()));
+	Tcl_ListObjAppendElement(interp, stats, Tcl_NewStringObj("load_ms", -1));
+	Tcl_ListObjAppendElement(interp, stats, Tcl_NewLongObj(cache->load_ticks()));
+
+	Tcl_SetObjResult(interp, stats);
+
+	return TCL_OK;
+}
+
+static void append_stat(Tcl_Interp* interp, Tcl_Obj* stats, const char* name, uint32_t value) {
+	Tcl_ListObjAppendElement(interp, stats, Tcl_NewStringObj(name, -1));
+	Tcl_ListObjAppendElement(interp, stats, Tcl_NewWideIntObj(value));
+}
+
+int tcl_stats(ClientData, Tcl_Interp* interp, int objc, Tcl_Obj * const*) {
+	if(objc != 1)
+		return TCL_ERROR;
+
+	screen* screen = bind->m_screen;
+	const frame_counters& frame = screen->counters();
+
+	Tcl_Obj* stats = Tcl_NewListObj(0, NULL);
+
+	// Last frame
+
+	append_stat(interp, stats, "blits", frame.blits);
+	append_stat(interp, stats, "pixels", frame.pixels);
+	append_stat(interp, stats, "culled", frame.culled);
+	append_stat(interp, stats, "surfaces_created", frame.surfaces_created);
+	append_stat(interp, stats, "surfaces_freed", frame.surfaces_freed);
+	append_stat(interp, stats, "obstruction_tests", frame.obstruction_tests);
+	append_stat(interp, stats, "allocations", screen->frame_allocations());
+	append_stat(interp, stats, "sprites", screen->sprite_count());
+	append_stat(interp, stats, "awake", screen->awake_count());
+	append_stat(interp, stats, "animations", screen->templates()->count());
+
+	// Since the start
+
+	append_stat(interp, stats, "cache_hits", screen->cache()->hits());
+	append_stat(interp, stats, "cache_misses", screen->cache()->misses());
+	append_stat(interp, stats, "events", bind->m_queue->dispatched());
+	append_stat(interp, stats, "evals", bind->evals());
+
+	Tcl_SetObjResult(interp, stats);
+
+	return TCL_OK;
+}
+
+int tcl_sample_stats(ClientData, Tcl_Interp* interp, int objc, Tcl_Obj * const*) {
+	if(objc != 1)
+		return TCL_ERROR;
+
+	sample_cache* samples = bind->m_player->samples();
+
+	Tcl_Obj* stats = Tcl_NewListObj(0, NULL);
+
+	if(samples != NULL) {
+		uint32_t lookups = samples->hits() + samples->misses();
+
+		append_stat(interp, stats, "hits", samples->hits());
+		append_stat(interp, stats, "misses", samples->misses());
+
+		Tcl_ListObjAppendElement(interp, stats, Tcl_NewStringObj("hit_rate", -1));
+		Tcl_ListObjAppendElement(interp, stats, Tcl_NewDoubleObj(lookups > 0 ? (double)samples->hits() / lookups : 0.0));
+
+		append_stat(interp, stats, "evictions", samples->evictions());
+		append_stat(interp, stats, "samples", samples->count());
+		append_stat(interp, stats, "bytes", samples->bytes());
+		append_stat(interp, stats, "budget", samples->budget());
+	}
+
+	Tcl_SetObjResult(interp, stats);
+
+	return TCL_OK;
+}
+
+int tcl_profile(ClientData, Tcl_Interp* interp, int objc, Tcl_Obj * const* objv) {
+	if(objc != 1 && objc != 3)
+		return TCL_ERROR;
+
+	if(objc == 3) {
+		if(strcmp(Tcl_GetStringFromObj(objv[1], NULL), "graph") != 0)
+			return TCL_ERROR;
+
+		int graph;
+
+		if(Tcl_GetBooleanFromObj(interp, objv[2], &graph) != TCL_OK)
+			return TCL_ERROR;
+
+		profiler::graph(graph);
+
+		return TCL_OK;
+	}
+
+	// Name followed by average and maximum microseconds per frame, for each phase
+
+	Tcl_Obj* summary = Tcl_NewListObj(0, NULL);
+
+	for(uint8_t i = 0; i < profiler::PHASE_COUNT; i++) {
+		profiler::phase phase = (profiler::phase)i;
+
+		Tcl_Obj* times = Tcl_NewListObj(0, NULL);
+
+		Tcl_ListObjAppendElement(interp, times, Tcl_NewLongObj(profiler::average(phase)));
+		Tcl_ListObjAppendElement(interp, times, Tcl_NewLongObj(profiler::maximum(phase)));
+
+		Tcl_ListObjAppendElement(interp, summary, Tcl_NewStringObj(profiler::name(phase), -1));
+		Tcl_ListObjAppendElement(interp, summary, times);
+	}
+
+	Tcl_SetObjResult(interp, summary);
 
 	return TCL_OK;
 }
@@ -666,13 +1247,15 @@ tcl_bind::tcl_bind(Tcl_Interp* interp, screen* screen, audio_player* player, eve
 	m_screen = screen;
 	m_player = player;
 	m_queue = queue;
+
+	m_evals = 0;
 }
 
 void tcl_bind::init_namespace() {
 	if(
 		Tcl_Eval(m_interp, "\
 			namespace eval ::faw::core {\
-			namespace export path tint sprite dragsprite layer map player follow obstruct animate x y alpha move fade angle rotate rotate_cycle tassenhalter text sound music on unbind}\
+			namespace export path tint overlay sprite dragsprite layer map player sheet clip emitter emit follow raw_motion input obstruct animate x y alpha move fade angle rotate rotate_cycle tassenhalter text sound stop volume preload music music_volume cache_stats sample_stats stats profile on unbind}\
 			")
 		!= TCL_OK
 	) {
@@ -686,13 +1269,20 @@ void tcl_bind::bind_all() {
 	Tcl_SetVar(m_interp, "::faw::path", file::path().c_str(), 0);
 
 	Tcl_CreateObjCommand(m_interp, "::faw::core::tint", tcl_tint, NULL, NULL);
+	Tcl_CreateObjCommand(m_interp, "::faw::core::overlay", tcl_overlay, NULL, NULL);
 
 	Tcl_CreateObjCommand(m_interp, "::faw::core::sprite", tcl_sprite, NULL, NULL);
 	Tcl_CreateObjCommand(m_interp, "::faw::core::dragsprite", tcl_dragsprite, NULL, NULL);
 	Tcl_CreateObjCommand(m_interp, "::faw::core::map", tcl_map, NULL, NULL);
 	Tcl_CreateObjCommand(m_interp, "::faw::core::layer", tcl_layer, NULL, NULL);
 	Tcl_CreateObjCommand(m_interp, "::faw::core::player", tcl_player, NULL, NULL);
+	Tcl_CreateObjCommand(m_interp, "::faw::core::sheet", tcl_sheet, NULL, NULL);
+	Tcl_CreateObjCommand(m_interp, "::faw::core::clip", tcl_clip, NULL, NULL);
+	Tcl_CreateObjCommand(m_interp, "::faw::core::emitter", tcl_emitter, NULL, NULL);
+	Tcl_CreateObjCommand(m_interp, "::faw::core::emit", tcl_emit, NULL, NULL);
 	Tcl_CreateObjCommand(m_interp, "::faw::core::follow", tcl_follow, NULL, NULL);
+	Tcl_CreateObjCommand(m_interp, "::faw::core::raw_motion", tcl_raw_motion, NULL, NULL);
+	Tcl_CreateObjCommand(m_interp, "::faw::core::input", tcl_input, NULL, NULL);
 	Tcl_CreateObjCommand(m_interp, "::faw::core::obstruct", tcl_obstruct, NULL, NULL);
 	Tcl_CreateObjCommand(m_interp, "::faw::core::animate", tcl_animate, NULL, NULL);
 	Tcl_CreateObjCommand(m_interp, "::faw::core::x", tcl_x, NULL, NULL);
@@ -707,7 +1297,16 @@ void tcl_bind::bind_all() {
 	Tcl_CreateObjCommand(m_interp, "::faw::core::text", tcl_text, NULL, NULL);
 
 	Tcl_CreateObjCommand(m_interp, "::faw::core::sound", tcl_sound, NULL, NULL);
+	Tcl_CreateObjCommand(m_interp, "::faw::core::stop", tcl_stop, NULL, NULL);
+	Tcl_CreateObjCommand(m_interp, "::faw::core::volume", tcl_volume, NULL, NULL);
+	Tcl_CreateObjCommand(m_interp, "::faw::core::preload", tcl_preload, NULL, NULL);
 	Tcl_CreateObjCommand(m_interp, "::faw::core::music", tcl_music, NULL, NULL);
+	Tcl_CreateObjCommand(m_interp, "::faw::core::music_volume", tcl_music_volume, NULL, NULL);
+
+	Tcl_CreateObjCommand(m_interp, "::faw::core::cache_stats", tcl_cache_stats, NULL, NULL);
+	Tcl_CreateObjCommand(m_interp, "::faw::core::sample_stats", tcl_sample_stats, NULL, NULL);
+	Tcl_CreateObjCommand(m_interp, "::faw::core::stats", tcl_stats, NULL, NULL);
+	Tcl_CreateObjCommand(m_interp, "::faw::core::profile", tcl_profile, NULL, NULL);
 
 	Tcl_CreateObjCommand(m_interp, "::faw::core::on", tcl_on, NULL, NULL);
 	Tcl_CreateObjCommand(m_interp, "::faw::core::unbind", tcl_unbind, NULL, NULL);
@@ -752,6 +1351,8 @@ void tcl_bind::call_handler_code(const event_handler* handler, const std::string
 	if(Tcl_CommandComplete((*type_result).second.c_str()) == 0)
 		error_message("Syntax error in handler code for ", type);
 
+	m_evals++;
+
 	if(Tcl_Eval(m_interp, (*type_result).second.c_str()) != TCL_OK)
 		error_message("Runtime error in handler code:\n\n", Tcl_GetVar(m_interp, "errorInfo", TCL_GLOBAL_ONLY));
 }
@@ -767,12 +1368,18 @@ bool tcl_bind::call_event_code(const std::string &type, const std::string& var)
 	if(Tcl_CommandComplete((*result).second.c_str()) == 0)
 		error_message("Syntax error in event code for ", type);
 
+	m_evals++;
+
 	if(Tcl_Eval(m_interp, (*result).second.c_str()) != TCL_OK)
 		error_message("Runtime error in event code:\n\n", Tcl_GetVar(m_interp, "errorInfo", TCL_GLOBAL_ONLY));
 
 	return true;
 }
 
+uint32_t tcl_bind::evals() const {
+	return m_evals;
+}
+
 void tcl_bind::add_wait(const std::string &type, const std::string& var) {
 	waits[type] = var;
 }
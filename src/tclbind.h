@@ -48,6 +48,8 @@ private:
     handler_map handler_codes;
     type_map event_codes;
     type_map waits;
+
+    mutable uint32_t m_evals;
 public:
     screen* m_screen; // Naughty, naughty
     event_queue* m_queue; // ditto
@@ -68,6 +70,11 @@ public:
     void add_wait(const std::string &type, const std::string& var);
 
     void remove_event(const std::string& type);
+
+    /**
+     * Event and handler scripts evaluated so far.
+     */
+    uint32_t evals() const;
 };
 
 #endif // TCLBIND_H
@@ -25,7 +25,7 @@ set piclayer [layer]
 
 ::faw::lib::textbox::init $piclayer
 
-sound files/sound/music/test.mid
+music files/sound/music/test.mid
 
 set player [char player zeppon $mid]
 
@@ -1,5 +1,5 @@
 namespace eval ::faw::lib::char {
-	namespace export char
+	namespace export char charsheet
 
 	namespace import ::faw::core::*
 }
@@ -19,3 +19,18 @@ proc ::faw::lib::char::char {type name layer} {
 
 	return [$type $n $s $w $e $layer]
 }
+
+# Same as char, but from one sheet: a row per direction (n s w e), columns m l r of w by h pixels
+proc ::faw::lib::char::charsheet {type name w h layer} {
+	set sheet files/img/chars/$name.png
+	set rows [list n s w e]
+
+	set char [$type {} {} {} {} $layer]
+
+	for {set row 0} {$row < 4} {incr row} {
+		set first [expr {$row * 3}]
+		sheet $char [lindex $rows $row] $sheet $w $h [list $first [expr {$first + 1}] $first [expr {$first + 2}]]
+	}
+
+	return $char
+}